@@ -0,0 +1,174 @@
+#ifndef SJTU_ASYNC_LRU_HPP
+#define SJTU_ASYNC_LRU_HPP
+
+#include "lru.hpp"
+#include "thread-pool.hpp"
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace sjtu {
+    /**
+     * awaitable lookups on an lru shared with coroutines (C++20 only).
+     * a hit completes in await_ready(), so awaiting it neither suspends
+     * nor allocates. a miss suspends the coroutine while the loader runs
+     * on the thread pool, and every coroutine awaiting the same key in the
+     * meantime joins that one load and is resumed with it.
+     * all access to the lru goes through the mutex of this object.
+     * loads in flight refer to it, so it must outlive them.
+     * the loader runs on a pool thread, as does the save of what it found.
+     */
+    class async_lru {
+        struct flight {
+            std::vector<std::coroutine_handle<> > waiters;
+            bool found = false;
+            Matrix<int> value;
+            std::exception_ptr error;
+        };
+        typedef std::shared_ptr<flight> flight_ptr;
+
+        lru &cache;
+        thread_pool &pool;
+        std::mutex lock;
+        hashmap<int, flight_ptr> flights;
+
+        /**
+         * run the loader on a pool thread, save what it found,
+         * then resume everyone who waited for key
+         */
+        template <class Loader>
+        void fly(int key, Loader &loader, const flight_ptr &f) {
+            Matrix<int> value;
+            bool found = false;
+            try {
+                found = loader(key, value);
+            } catch (...) {
+                f->error = std::current_exception();
+            }
+            std::vector<std::coroutine_handle<> > waiters;
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                if (found) {
+                    f->value = value;
+                    cache.save(pair<const Integer, Matrix<int> >(Integer(key), std::move(value)));
+                }
+                f->found = found;
+                waiters.swap(f->waiters);
+                flights.remove(key);
+            }
+            for (size_t i = 0; i + 1 < waiters.size(); i++) {
+                pool.submit([h = waiters[i]] { h.resume(); });
+            }
+            if (!waiters.empty()) waiters.back().resume();
+        }
+
+    public:
+        /**
+         * the result of co_get() (Loader is std::nullptr_t)
+         * and of co_get_or_load()
+         */
+        template <class Loader>
+        class awaiter {
+            async_lru &owner;
+            int key;
+            Loader loader;
+            bool hit;
+            Matrix<int> value;
+            flight_ptr joined;
+
+        public:
+            awaiter(async_lru &owner, int key, Loader loader)
+                : owner(owner), key(key), loader(std::move(loader)), hit(false) {}
+
+            bool await_ready() {
+                std::lock_guard<std::mutex> guard(owner.lock);
+                hit = owner.cache.try_lookup(key, value);
+                return hit;
+            }
+            bool await_suspend(std::coroutine_handle<> h) {
+                std::unique_lock<std::mutex> guard(owner.lock);
+                hit = owner.cache.try_lookup(key, value);
+                if (hit) return false;
+                auto it = owner.flights.find(key);
+                if (it != owner.flights.end()) {
+                    joined = it->second;
+                    joined->waiters.push_back(h);
+                    return true;
+                }
+                if constexpr (std::is_same<Loader, std::nullptr_t>::value) {
+                    return false;
+                } else {
+                    flight_ptr f = std::make_shared<flight>();
+                    f->waiters.push_back(h);
+                    joined = f;
+                    owner.flights.insert(pair<const int, flight_ptr>(key, f));
+                    guard.unlock();
+                    // h may be resumed (and this destroyed) before submit() returns
+                    async_lru *o = &owner;
+                    int k = key;
+                    o->pool.submit([o, k, f, loader = std::move(loader)]() mutable { o->fly(k, loader, f); });
+                    return true;
+                }
+            }
+            /**
+             * the value; if there is none, throw
+             */
+            Matrix<int> await_resume() {
+                if (hit) return std::move(value);
+                if (joined) {
+                    if (joined->error) std::rethrow_exception(joined->error);
+                    if (joined->found) return joined->value;
+                }
+                throw index_out_of_bound();
+            }
+        };
+
+        async_lru(lru &cache, thread_pool &pool) : cache(cache), pool(pool) {}
+        async_lru(const async_lru &other) = delete;
+        async_lru &operator=(const async_lru &other) = delete;
+
+        /**
+         * the value connected with key, waiting for a load of key
+         * in flight if there is one; if there is none, throw
+         */
+        awaiter<std::nullptr_t> co_get(int key) {
+            return awaiter<std::nullptr_t>(*this, key, nullptr);
+        }
+        awaiter<std::nullptr_t> co_get(const Integer &key) {
+            return co_get(key.val);
+        }
+        /**
+         * like co_get(), but a miss calls loader(key, value) on the pool,
+         * which returns false if there is no value (then throw).
+         * what it finds is saved in the lru
+         */
+        template <class Loader>
+        awaiter<Loader> co_get_or_load(int key, Loader loader) {
+            return awaiter<Loader>(*this, key, std::move(loader));
+        }
+        template <class Loader>
+        awaiter<Loader> co_get_or_load(const Integer &key, Loader loader) {
+            return co_get_or_load(key.val, std::move(loader));
+        }
+
+        /**
+         * call fn(lru) holding the mutex, for anything else
+         */
+        template <class Fn>
+        auto with(Fn fn) {
+            std::lock_guard<std::mutex> guard(lock);
+            return fn(cache);
+        }
+    };
+}
+
+#endif
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef SJTU_BLOOM_FILTER_HPP
+#define SJTU_BLOOM_FILTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace sjtu {
+    /**
+     * a blocked Bloom filter over hash values: all the bits of a key lie
+     * in one 64-byte block, so a query reads a single cache line.
+     * the high half of the mixed hash picks the block, the low half
+     * gives the n_bits positions in it by double hashing.
+     * no false negatives; keys can't be removed, rebuild it instead
+     */
+    class blocked_bloom {
+        struct alignas(64) block {
+            std::uint64_t words[8];
+        };
+        static const int n_bits = 6;        // bits set per key
+        static const int bits_per_key = 12;
+
+        std::vector<block> blocks;
+        std::size_t mask;
+
+        static std::uint64_t mix(std::uint64_t hash) {
+            hash ^= hash >> 33;
+            hash *= 0xff51afd7ed558ccdULL;
+            hash ^= hash >> 33;
+            hash *= 0xc4ceb9fe1a85ec53ULL;
+            hash ^= hash >> 33;
+            return hash;
+        }
+
+    public:
+        explicit blocked_bloom(std::size_t expected = 0) {
+            reset(expected);
+        }
+
+        /**
+         * empty the filter, sized for expected keys
+         */
+        void reset(std::size_t expected) {
+            std::size_t n = 1;
+            while (n * 512 < expected * bits_per_key) n <<= 1;
+            blocks.assign(n, block());
+            for (auto &b : blocks) {
+                for (auto &w : b.words) w = 0;
+            }
+            mask = n - 1;
+        }
+
+        void add(std::uint64_t hash) {
+            std::uint64_t h = mix(hash);
+            block &b = blocks[(h >> 32) & mask];
+            std::uint32_t bit = h & 511, step = (h >> 9 & 511) | 1;
+            for (int i = 0; i < n_bits; i++, bit = (bit + step) & 511) {
+                b.words[bit >> 6] |= std::uint64_t(1) << (bit & 63);
+            }
+        }
+
+        /**
+         * false means the key was never added
+         */
+        bool may_contain(std::uint64_t hash) const {
+            std::uint64_t h = mix(hash);
+            const block &b = blocks[(h >> 32) & mask];
+            std::uint32_t bit = h & 511, step = (h >> 9 & 511) | 1;
+            for (int i = 0; i < n_bits; i++, bit = (bit + step) & 511) {
+                if (!(b.words[bit >> 6] >> (bit & 63) & 1)) return false;
+            }
+            return true;
+        }
+    };
+}
+
+#endif
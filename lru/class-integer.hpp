@@ -1,9 +1,11 @@
 #ifndef SJTU_INTEGER_HPP
 #define SJTU_INTEGER_HPP
 
+#include <atomic>
+
 class Integer {
 public:
-	static int counter;
+	static std::atomic<int> counter;	// atomic, keys are made and dropped on pool threads too
 	int val;
 	
 	Integer(int val) : val(val) {counter++;}
@@ -19,6 +21,6 @@ public:
 	}
 };
 
-int Integer::counter = 0;
+std::atomic<int> Integer::counter(0);
 
 #endif
\ No newline at end of file
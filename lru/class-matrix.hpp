@@ -3,28 +3,169 @@
 
 #include <iostream>
 #include <iomanip>
+#include <memory>
+#include <new>
 #include <vector>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
 
+#include "matrix-kernel.hpp"
+#include "thread-pool.hpp"
+
+/**
+ * Allocator handing out blocks aligned to _Align bytes,
+ * so that every matrix starts on its own cache line.
+ */
+template<typename _Td, size_t _Align = 64>
+class AlignedAllocator {
+public:
+    typedef _Td value_type;
+    template<typename _Tu>
+    struct rebind {
+        typedef AlignedAllocator<_Tu, _Align> other;
+    };
+    AlignedAllocator() noexcept {}
+    template<typename _Tu>
+    AlignedAllocator(const AlignedAllocator<_Tu, _Align> &) noexcept {}
+    _Td * allocate(size_t n)
+    {
+#ifdef __cpp_aligned_new
+        return static_cast<_Td *>(::operator new(n * sizeof(_Td), std::align_val_t(_Align)));
+#else
+        return static_cast<_Td *>(::operator new(n * sizeof(_Td)));
+#endif
+    }
+    void deallocate(_Td *p, size_t)
+    {
+#ifdef __cpp_aligned_new
+        ::operator delete(p, std::align_val_t(_Align));
+#else
+        ::operator delete(p);
+#endif
+    }
+    template<typename _Tu>
+    bool operator==(const AlignedAllocator<_Tu, _Align> &) const noexcept
+    {
+        return true;
+    }
+    template<typename _Tu>
+    bool operator!=(const AlignedAllocator<_Tu, _Align> &) const noexcept
+    {
+        return false;
+    }
+};
+
+/**
+ * Parallel execution of the Matrix operators.
+ * An operator whose work reaches Threshold() is split into row (or
+ * element) ranges and run on the executor of the innermost
+ * MatrixExecutor scope of the calling thread, or else on Default().
+ * Without an executor, or below the threshold, it runs serially.
+ */
+class MatrixExecutor {
+    sjtu::thread_pool *saved;
+public:
+    explicit MatrixExecutor(sjtu::thread_pool &pool) : saved(Scoped())
+    {
+        Scoped() = &pool;
+    }
+    MatrixExecutor(const MatrixExecutor &) = delete;
+    MatrixExecutor & operator=(const MatrixExecutor &) = delete;
+    ~MatrixExecutor()
+    {
+        Scoped() = saved;
+    }
+    static sjtu::thread_pool *& Scoped()
+    {
+        static thread_local sjtu::thread_pool *pool = nullptr;
+        return pool;
+    }
+    static sjtu::thread_pool *& Default()
+    {
+        static sjtu::thread_pool *pool = nullptr;
+        return pool;
+    }
+    /**
+     * Work (elements, or multiply-adds for products) below which
+     * an operator stays on the calling thread.
+     */
+    static size_t & Threshold()
+    {
+        static size_t threshold = 1 << 18;
+        return threshold;
+    }
+    /**
+     * Call fn(lo, hi) over [0, n), in parallel when work is large enough.
+     */
+    template<typename _Fn>
+    static void For(const size_t &n, const size_t &work, const _Fn &fn)
+    {
+        sjtu::thread_pool *pool = Scoped() ? Scoped() : Default();
+        if (pool == nullptr || work < Threshold() || n < 2) {
+            fn(0, n);
+            return;
+        }
+        pool->parallel_for(0, n, 1, fn);
+    }
+};
+
+template<typename _Td>
+class Matrix;
+
+/**
+ * Expression templates.
+ * +, -, negation and the scalar * and / do not compute anything: they
+ * return small nodes describing the element-wise formula, so a chain
+ * such as a + b - c * 2 is evaluated in one pass over the elements,
+ * straight into the Matrix it initializes or is assigned to.
+ * Products and transposes are not element-wise and still materialize.
+ * Nodes refer to lvalue matrices, so keep them in the same statement
+ * (or store the result in a Matrix rather than in auto).
+ */
+class MatrixExprTag {};
+
+template<typename _Td, typename _Ex>
+class MatrixExpr : public MatrixExprTag {
+public:
+    typedef _Td value_type;
+    inline const _Ex & Self() const
+    {
+        return static_cast<const _Ex &>(*this);
+    }
+};
+
+template<typename _Ex>
+struct IsMatrixExpr : std::is_base_of<MatrixExprTag, typename std::decay<_Ex>::type> {};
+
+/**
+ * Dense matrix stored row-major in one contiguous aligned buffer.
+ * The buffer is copy-on-write: copies share it (one reference count
+ * increment, no payload copy), and the first mutable access through a
+ * shared copy (non-const operator[] or Data()) gives that copy its own
+ * buffer. A shared buffer is never written, so readers holding copies
+ * on other threads are safe.
+ */
 template<typename _Td>
-class Matrix {
+class Matrix : public MatrixExpr<_Td, Matrix<_Td>> {
 protected:
+    typedef std::vector<_Td, AlignedAllocator<_Td>> Buffer;
     size_t n_rows = 0;
     size_t n_cols = 0;
-    std::vector<std::vector<_Td>> data;
+    std::shared_ptr<Buffer> data;
     class RowProxy {
-        std::vector<_Td> &row;
+        _Td *row;
     public:
-        RowProxy(std::vector<_Td> & _row) : row(_row) {}
+        RowProxy(_Td *_row) : row(_row) {}
         _Td & operator[](const size_t &pos)
         {
             return row[pos];
         }
     };
     class ConstRowProxy {
-        const std::vector<_Td> &row;
+        const _Td *row;
     public:
-        ConstRowProxy(const std::vector<_Td> &_row) : row(_row) {}
+        ConstRowProxy(const _Td *_row) : row(_row) {}
         const _Td & operator[](const size_t &pos) const
         {
             return row[pos];
@@ -33,13 +174,19 @@ protected:
 public:
     Matrix() {};
     Matrix(const size_t &_n_rows, const size_t &_n_cols)
-        : n_rows(_n_rows), n_cols(_n_cols), data(std::vector<std::vector<_Td>>(n_rows, std::vector<_Td>(n_cols))) {}
+        : n_rows(_n_rows), n_cols(_n_cols), data(std::make_shared<Buffer>(n_rows * n_cols)) {}
     Matrix(const size_t &_n_rows, const size_t &_n_cols, const _Td &fillValue)
-        : n_rows(_n_rows), n_cols(_n_cols), data(std::vector<std::vector<_Td>>(n_rows, std::vector<_Td>(n_cols, fillValue))) {}
+        : n_rows(_n_rows), n_cols(_n_cols), data(std::make_shared<Buffer>(n_rows * n_cols, fillValue)) {}
     Matrix(const Matrix<_Td> &mat)
         : n_rows(mat.n_rows), n_cols(mat.n_cols), data(mat.data) {}
+    /**
+     * the source is left an empty 0x0 Matrix
+     */
     Matrix(Matrix<_Td> &&mat) noexcept
-        : n_rows(mat.n_rows), n_cols(mat.n_cols), data(mat.data) {}
+        : n_rows(mat.n_rows), n_cols(mat.n_cols), data(std::move(mat.data))
+    {
+        mat.n_rows = mat.n_cols = 0;
+    }
     Matrix<_Td> & operator=(const Matrix<_Td> &rhs)
     {
         this->n_rows = rhs.n_rows;
@@ -49,9 +196,40 @@ public:
     }
     Matrix<_Td> & operator=(Matrix<_Td> &&rhs)
     {
+        if (this == &rhs) return *this;
         this->n_rows = rhs.n_rows;
         this->n_cols = rhs.n_cols;
-        this->data = rhs.data;
+        this->data = std::move(rhs.data);
+        rhs.n_rows = rhs.n_cols = 0;
+        return *this;
+    }
+    /**
+     * Evaluate an element-wise expression in one pass.
+     */
+    template<typename _Ex>
+    Matrix(const MatrixExpr<_Td, _Ex> &expr)
+        : n_rows(expr.Self().RowSize()), n_cols(expr.Self().ColSize()), data(std::make_shared<Buffer>(n_rows * n_cols))
+    {
+        Assign(data->data(), expr.Self());
+    }
+    /**
+     * Every node reads element i only to produce element i, so an
+     * unshared buffer of the right shape is overwritten in place even
+     * if this matrix appears in the expression; otherwise the result
+     * goes to a new buffer.
+     */
+    template<typename _Ex>
+    Matrix<_Td> & operator=(const MatrixExpr<_Td, _Ex> &expr)
+    {
+        if (this->n_rows != expr.Self().RowSize() || this->n_cols != expr.Self().ColSize() || Shared()) {
+            std::shared_ptr<Buffer> fresh = std::make_shared<Buffer>(expr.Self().RowSize() * expr.Self().ColSize());
+            Assign(fresh->data(), expr.Self());
+            this->n_rows = expr.Self().RowSize();
+            this->n_cols = expr.Self().ColSize();
+            this->data = std::move(fresh);
+        } else {
+            Assign(data->data(), expr.Self());
+        }
         return *this;
     }
     inline const size_t & RowSize() const
@@ -62,161 +240,354 @@ public:
     {
         return n_cols;
     }
+    inline size_t Size() const
+    {
+        return n_rows * n_cols;
+    }
+    /**
+     * Whether another Matrix shares this buffer.
+     */
+    inline bool Shared() const
+    {
+        return data && data.use_count() > 1;
+    }
+    /**
+     * The row-major buffer, element (i, j) is at i * ColSize() + j.
+     * The mutable one first unshares the buffer, so the pointer (and a
+     * RowProxy, which holds one) is only safe to write through until
+     * this matrix is copied again: the copy shares the same buffer.
+     */
+    inline _Td * Data()
+    {
+        Detach();
+        return data ? data->data() : nullptr;
+    }
+    inline const _Td * Data() const
+    {
+        return data ? data->data() : nullptr;
+    }
+    inline const _Td & Eval(const size_t &i) const
+    {
+        return (*data)[i];
+    }
     RowProxy operator[](const size_t &Kth)
     {
-        return RowProxy(this->data[Kth]);
+        return RowProxy(Data() + Kth * n_cols);
     }
     const ConstRowProxy operator[](const size_t &Kth) const
     {
-        return ConstRowProxy(this->data[Kth]);
+        return ConstRowProxy(Data() + Kth * n_cols);
     }
     ~Matrix() = default;
+private:
+    void Detach()
+    {
+        if (Shared()) {
+            data = std::make_shared<Buffer>(*data);
+        }
+    }
+    template<typename _Ex>
+    static void Assign(_Td *p, const _Ex &expr)
+    {
+        const size_t n = expr.RowSize() * expr.ColSize();
+        MatrixExecutor::For(n, n, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; ++i) {
+                p[i] = expr.Eval(i);
+            }
+        });
+    }
 };
 
 /**
- * Sum of two matrics.
+ * How a node keeps an operand: lvalue matrices by reference,
+ * rvalue matrices (e.g. a product) and other nodes by value.
  */
+template<typename _Ex>
+struct MatrixOperand {
+    typedef typename std::decay<_Ex>::type type;
+};
 template<typename _Td>
-Matrix<_Td> operator+(const Matrix<_Td> &a, const Matrix<_Td> &b)
-{
-    if (a.RowSize() != b.RowSize() || a.ColSize() != b.ColSize()) {
-        throw std::invalid_argument("different matrics\'s sizes");
+struct MatrixOperand<Matrix<_Td> &> {
+    typedef const Matrix<_Td> &type;
+};
+template<typename _Td>
+struct MatrixOperand<const Matrix<_Td> &> {
+    typedef const Matrix<_Td> &type;
+};
+
+template<typename _Ex>
+struct MatrixValue {
+    typedef typename std::decay<_Ex>::type::value_type type;
+};
+
+struct MatrixPlus {
+    template<typename _Ta, typename _Tb>
+    auto operator()(const _Ta &a, const _Tb &b) const -> decltype(a + b)
+    {
+        return a + b;
+    }
+};
+struct MatrixMinus {
+    template<typename _Ta, typename _Tb>
+    auto operator()(const _Ta &a, const _Tb &b) const -> decltype(a - b)
+    {
+        return a - b;
+    }
+};
+struct MatrixTimes {
+    template<typename _Ta, typename _Tb>
+    auto operator()(const _Ta &a, const _Tb &b) const -> decltype(a * b)
+    {
+        return a * b;
+    }
+};
+struct MatrixDivides {
+    template<typename _Ta, typename _Tb>
+    auto operator()(const _Ta &a, const _Tb &b) const -> decltype(a / b)
+    {
+        return a / b;
+    }
+};
+struct MatrixNegate {
+    template<typename _Ta>
+    auto operator()(const _Ta &a) const -> decltype(-a)
+    {
+        return -a;
     }
-    Matrix<_Td> c(a.RowSize(), a.ColSize());
-    for (size_t i = 0; i < a.RowSize(); ++i) {
-        for (size_t j = 0; j < a.ColSize(); ++j) {
-            c[i][j] = a[i][j] + b[i][j];
+};
+
+/**
+ * lhs op rhs, element by element.
+ */
+template<typename _Td, typename _L, typename _R, typename _Op>
+class MatrixBinary : public MatrixExpr<_Td, MatrixBinary<_Td, _L, _R, _Op>> {
+    typename MatrixOperand<_L>::type lhs;
+    typename MatrixOperand<_R>::type rhs;
+public:
+    MatrixBinary(_L &&_lhs, _R &&_rhs) : lhs(std::forward<_L>(_lhs)), rhs(std::forward<_R>(_rhs))
+    {
+        if (lhs.RowSize() != rhs.RowSize() || lhs.ColSize() != rhs.ColSize()) {
+            throw std::invalid_argument("different matrics\'s sizes");
         }
     }
-    return c;
-}
+    inline size_t RowSize() const
+    {
+        return lhs.RowSize();
+    }
+    inline size_t ColSize() const
+    {
+        return lhs.ColSize();
+    }
+    inline _Td Eval(const size_t &i) const
+    {
+        return _Op()(lhs.Eval(i), rhs.Eval(i));
+    }
+};
 
-template<typename _Td>
-Matrix<_Td> operator-(const Matrix<_Td> &a, const Matrix<_Td> &b)
-{
-    if (a.RowSize() != b.RowSize() || a.ColSize() != b.ColSize()) {
-        throw std::invalid_argument("different matrics\'s sizes");
+/**
+ * expr op scalar, element by element.
+ */
+template<typename _Td, typename _E, typename _Ts, typename _Op>
+class MatrixScalar : public MatrixExpr<_Td, MatrixScalar<_Td, _E, _Ts, _Op>> {
+    typename MatrixOperand<_E>::type expr;
+    _Ts scalar;
+public:
+    MatrixScalar(_E &&_expr, const _Ts &_scalar) : expr(std::forward<_E>(_expr)), scalar(_scalar) {}
+    inline size_t RowSize() const
+    {
+        return expr.RowSize();
     }
-    Matrix<_Td> c(a.RowSize(), a.ColSize());
-    for (size_t i = 0; i < a.RowSize(); ++i) {
-        for (size_t j = 0; j < a.ColSize(); ++j) {
-            c[i][j] = a[i][j] - b[i][j];
-        }
+    inline size_t ColSize() const
+    {
+        return expr.ColSize();
     }
-    return c;
-}
+    inline _Td Eval(const size_t &i) const
+    {
+        return _Op()(expr.Eval(i), scalar);
+    }
+};
+
+/**
+ * op expr, element by element.
+ */
+template<typename _Td, typename _E, typename _Op>
+class MatrixUnary : public MatrixExpr<_Td, MatrixUnary<_Td, _E, _Op>> {
+    typename MatrixOperand<_E>::type expr;
+public:
+    explicit MatrixUnary(_E &&_expr) : expr(std::forward<_E>(_expr)) {}
+    inline size_t RowSize() const
+    {
+        return expr.RowSize();
+    }
+    inline size_t ColSize() const
+    {
+        return expr.ColSize();
+    }
+    inline _Td Eval(const size_t &i) const
+    {
+        return _Op()(expr.Eval(i));
+    }
+};
+
+/**
+ * A Matrix as is, or an expression evaluated into a new one.
+ */
 template<typename _Td>
-bool operator==(const Matrix<_Td> &a, const Matrix<_Td> &b)
+const Matrix<_Td> & Materialize(const Matrix<_Td> &mat)
+{
+    return mat;
+}
+
+template<typename _Td, typename _Ex>
+Matrix<_Td> Materialize(const MatrixExpr<_Td, _Ex> &expr)
+{
+    return Matrix<_Td>(expr);
+}
+
+/**
+ * Sum of two matrics.
+ */
+template<typename _L, typename _R,
+         typename = typename std::enable_if<IsMatrixExpr<_L>::value && IsMatrixExpr<_R>::value>::type>
+MatrixBinary<typename MatrixValue<_L>::type, _L, _R, MatrixPlus> operator+(_L &&a, _R &&b)
+{
+    return MatrixBinary<typename MatrixValue<_L>::type, _L, _R, MatrixPlus>(std::forward<_L>(a), std::forward<_R>(b));
+}
+
+template<typename _L, typename _R,
+         typename = typename std::enable_if<IsMatrixExpr<_L>::value && IsMatrixExpr<_R>::value>::type>
+MatrixBinary<typename MatrixValue<_L>::type, _L, _R, MatrixMinus> operator-(_L &&a, _R &&b)
 {
-    if (a.RowSize() != b.RowSize() || a.ColSize() != b.ColSize()) {
+    return MatrixBinary<typename MatrixValue<_L>::type, _L, _R, MatrixMinus>(std::forward<_L>(a), std::forward<_R>(b));
+}
+
+template<typename _Td, typename _L, typename _R>
+bool operator==(const MatrixExpr<_Td, _L> &a, const MatrixExpr<_Td, _R> &b)
+{
+    const _L &lhs = a.Self();
+    const _R &rhs = b.Self();
+    if (lhs.RowSize() != rhs.RowSize() || lhs.ColSize() != rhs.ColSize()) {
         return false;
     }
-    for (size_t i = 0; i < a.RowSize(); ++i) {
-        for (size_t j = 0; j < a.ColSize(); ++j) {
-            if (a[i][j] != b[i][j])
-                return false;
-        }
+    for (size_t i = 0; i < lhs.RowSize() * lhs.ColSize(); ++i) {
+        if (lhs.Eval(i) != rhs.Eval(i))
+            return false;
     }
     return true;
 }
 
-template<typename _Td>
-Matrix<_Td> operator-(const Matrix<_Td> &mat)
+template<typename _E, typename = typename std::enable_if<IsMatrixExpr<_E>::value>::type>
+MatrixUnary<typename MatrixValue<_E>::type, _E, MatrixNegate> operator-(_E &&mat)
 {
-    Matrix<_Td> result(mat.RowSize(), mat.ColSize());
-    for (size_t i = 0; i < mat.RowSize(); ++i) {
-        for (size_t j = 0; j < mat.ColSize(); ++j) {
-            result[i][j] = -mat[i][j];
-        }
-    }
-    return result;
+    return MatrixUnary<typename MatrixValue<_E>::type, _E, MatrixNegate>(std::forward<_E>(mat));
 }
 
+/**
+ * A temporary is negated in place, no new buffer.
+ */
 template<typename _Td>
 Matrix<_Td> operator-(Matrix<_Td> &&mat)
 {
-    for (size_t i = 0; i < mat.RowSize(); ++i) {
-        for (size_t j = 0; j < mat.ColSize(); ++j) {
-            mat[i][j] = -mat[i][j];
+    _Td *pm = mat.Data();
+    MatrixExecutor::For(mat.Size(), mat.Size(), [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; ++i) {
+            pm[i] = -pm[i];
         }
-    }
-    return mat;
+    });
+    return std::move(mat);
 }
 
 /**
  * Multiplication of two matrics.
  */
-template<typename _Td>
-Matrix<_Td> operator*(const Matrix<_Td> &a, const Matrix<_Td> &b)
+template<typename _Td, typename _L, typename _R>
+Matrix<_Td> operator*(const MatrixExpr<_Td, _L> &lhs, const MatrixExpr<_Td, _R> &rhs)
 {
+    const auto &a = Materialize(lhs.Self());
+    const auto &b = Materialize(rhs.Self());
     if (a.ColSize() != b.RowSize()) {
         throw std::invalid_argument("different matrics\'s sizes");
     }
     Matrix<_Td> c(a.RowSize(), b.ColSize(), 0);
-    for (size_t i = 0; i < a.RowSize(); ++i) {
-        for (size_t j = 0; j < b.ColSize(); ++j) {
-            for (size_t k = 0; k < a.ColSize(); ++k) {
-                c[i][j] += a[i][k] * b[k][j];
-            }
-        }
-    }
+    const size_t n = b.ColSize(), k = a.ColSize();
+    const _Td *pa = a.Data(), *pb = b.Data();
+    _Td *pc = c.Data();
+    MatrixExecutor::For(a.RowSize(), a.RowSize() * n * k, [&](size_t lo, size_t hi) {
+        matrix_kernel::Gemm(pa + lo * k, pb, pc + lo * n, hi - lo, n, k);
+    });
     return c;
 }
 
 /**
- * Operations between a number and a matrix;
+ * a * Transpose(bt) without forming the transpose,
+ * both operands are walked along their rows.
  */
-template<typename _Td>
-Matrix<_Td> operator*(const Matrix<_Td> &a, const _Td &b)
+template<typename _Td, typename _L, typename _R>
+Matrix<_Td> MultiplyTransposed(const MatrixExpr<_Td, _L> &lhs, const MatrixExpr<_Td, _R> &rhs)
 {
-    Matrix<_Td> c(a.RowSize(), a.ColSize());
-    for (size_t i = 0; i < a.RowSize(); ++i) {
-        for (size_t j = 0; j < a.ColSize(); ++j) {
-            c[i][j] = a[i][j] * b;
-        }
+    const auto &a = Materialize(lhs.Self());
+    const auto &bt = Materialize(rhs.Self());
+    if (a.ColSize() != bt.ColSize()) {
+        throw std::invalid_argument("different matrics\'s sizes");
     }
+    Matrix<_Td> c(a.RowSize(), bt.RowSize(), 0);
+    const size_t n = bt.RowSize(), k = a.ColSize();
+    const _Td *pa = a.Data(), *pb = bt.Data();
+    _Td *pc = c.Data();
+    MatrixExecutor::For(a.RowSize(), a.RowSize() * n * k, [&](size_t lo, size_t hi) {
+        matrix_kernel::GemmTransposed(pa + lo * k, pb, pc + lo * n, hi - lo, n, k);
+    });
     return c;
 }
 
-template<typename _Td>
-Matrix<_Td> operator*(const _Td &b, const Matrix<_Td> &a)
+/**
+ * Operations between a number and a matrix;
+ */
+template<typename _E, typename = typename std::enable_if<IsMatrixExpr<_E>::value>::type>
+MatrixScalar<typename MatrixValue<_E>::type, _E, typename MatrixValue<_E>::type, MatrixTimes>
+operator*(_E &&a, const typename MatrixValue<_E>::type &b)
 {
-    Matrix<_Td> c(a.RowSize(), a.ColSize());
-    for (size_t i = 0; i < a.RowSize(); ++i) {
-        for (size_t j = 0; j < a.ColSize(); ++j) {
-            c[i][j] = a[i][j] * b;
-        }
-    }
-    return c;
+    return MatrixScalar<typename MatrixValue<_E>::type, _E, typename MatrixValue<_E>::type, MatrixTimes>(std::forward<_E>(a), b);
 }
 
-template<typename _Td>
-Matrix<_Td> operator/(const Matrix<_Td> &a, const double &b)
+template<typename _E, typename = typename std::enable_if<IsMatrixExpr<_E>::value>::type>
+MatrixScalar<typename MatrixValue<_E>::type, _E, typename MatrixValue<_E>::type, MatrixTimes>
+operator*(const typename MatrixValue<_E>::type &b, _E &&a)
 {
-    Matrix<_Td> c(a.RowSize(), a.ColSize());
-    for (size_t i = 0; i < a.RowSize(); ++i) {
-        for (size_t j = 0; j < a.ColSize(); ++j) {
-            c[i][j] = a[i][j] / b;
-        }
-    }
-    return c;
+    return MatrixScalar<typename MatrixValue<_E>::type, _E, typename MatrixValue<_E>::type, MatrixTimes>(std::forward<_E>(a), b);
 }
 
-template<typename _Td>
-Matrix<_Td> Transpose(const Matrix<_Td> &a)
+template<typename _E, typename = typename std::enable_if<IsMatrixExpr<_E>::value>::type>
+MatrixScalar<typename MatrixValue<_E>::type, _E, double, MatrixDivides> operator/(_E &&a, const double &b)
 {
+    return MatrixScalar<typename MatrixValue<_E>::type, _E, double, MatrixDivides>(std::forward<_E>(a), b);
+}
+
+template<typename _Td, typename _Ex>
+Matrix<_Td> Transpose(const MatrixExpr<_Td, _Ex> &expr)
+{
+    const auto &a = Materialize(expr.Self());
     Matrix<_Td> res(a.ColSize(), a.RowSize());
-    for (size_t i = 0; i < a.ColSize(); ++i) {
-        for (size_t j = 0; j < a.RowSize(); ++j) {
-            res[i][j] = a[j][i];
+    const size_t rows = a.RowSize(), cols = a.ColSize(), tile = 32;
+    const _Td *pa = a.Data();
+    _Td *pr = res.Data();
+    MatrixExecutor::For(cols, res.Size(), [&](size_t lo, size_t hi) {
+        for (size_t j0 = 0; j0 < rows; j0 += tile) {
+            const size_t j1 = std::min(rows, j0 + tile);
+            for (size_t i = lo; i < hi; ++i) {
+                for (size_t j = j0; j < j1; ++j) {
+                    pr[i * rows + j] = pa[j * cols + i];
+                }
+            }
         }
-    }
+    });
     return res;
 }
 
-template<typename _Td>
-std::ostream & operator<<(std::ostream &stream, const Matrix<_Td> &mat)
+template<typename _Td, typename _Ex>
+std::ostream & operator<<(std::ostream &stream, const MatrixExpr<_Td, _Ex> &expr)
 {
+    const auto &mat = Materialize(expr.Self());
     std::ostream::fmtflags oldFlags = stream.flags();
     stream.precision(8);
     stream.setf(std::ios::fixed | std::ios::right);
@@ -0,0 +1,516 @@
+#ifndef SJTU_COMPACT_HASHMAP_HPP
+#define SJTU_COMPACT_HASHMAP_HPP
+
+#include "lru.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+namespace sjtu {
+    /**
+     * linked_hashmap for small values: every entry lives in one contiguous
+     * slab, and the insertion order, the bucket chains and the free list
+     * are 32-bit slot indices instead of pointers.
+     * an entry is 16 bytes of links (prev, next, chain, hash) next to its
+     * value_pair, where linked_hashmap spends two 32-byte nodes, a separate
+     * value and a list per bucket; a bucket is one index.
+     * iterators are slot indices and stay valid until their entry goes.
+     * references to values move when the slab grows, reserve() first
+     * to keep them. at most 2^32 - 1 entries
+     */
+    template <
+        class Key,
+        class T,
+        class Hash = std::hash<Key>,
+        class Equal = std::equal_to<Key> >
+    class compact_linked_hashmap {
+    public:
+        typedef pair<const Key, T> value_type;
+        static constexpr std::uint32_t nil = 0xffffffffu;
+
+    private:
+        struct entry {
+            std::uint32_t prev;     // the insertion order
+            std::uint32_t next;
+            std::uint32_t chain;    // the next entry in the bucket, or on the free list
+            std::uint32_t hash;
+            alignas(value_type) unsigned char raw[sizeof(value_type)];
+        };
+
+        entry *slab;
+        std::uint32_t slots;        // entries the slab holds
+        std::uint32_t top;          // slots [0, top) were ever used
+        std::uint32_t free_head;
+        std::uint32_t first;        // the oldest entry
+        std::uint32_t last;
+        std::uint32_t *buckets;
+        std::uint32_t shift;        // 32 - log2(buckets)
+        std::uint32_t count_;
+
+        static constexpr std::uint32_t min_buckets = 16;
+
+        value_type *value_of(std::uint32_t i) const {
+            return std::launder(reinterpret_cast<value_type *>(slab[i].raw));
+        }
+        std::uint32_t n_buckets() const {
+            return std::uint32_t(1) << (32 - shift);
+        }
+        /**
+         * Fibonacci hashing, so that keys with a plain identity hash
+         * still spread over the power-of-two buckets
+         */
+        std::uint32_t bucket_of(std::uint32_t hash) const {
+            return (hash * 2654435769u) >> shift;
+        }
+        template <class K>
+        static std::uint32_t hash_of(const K &key) {
+            return static_cast<std::uint32_t>(Hash()(key));
+        }
+
+        template <class K>
+        std::uint32_t locate(const K &key) const {
+            std::uint32_t hash = hash_of(key);
+            for (std::uint32_t i = buckets[bucket_of(hash)]; i != nil; i = slab[i].chain) {
+                if (slab[i].hash == hash && Equal()(value_of(i)->first, key)) return i;
+            }
+            return nil;
+        }
+
+        /**
+         * move the slab to n slots, every entry keeps its index
+         */
+        void grow_slab(std::uint32_t n) {
+            entry *fresh = static_cast<entry *>(::operator new(sizeof(entry) * n));
+            for (std::uint32_t i = 0; i < top; i++) {
+                fresh[i].prev = slab[i].prev;
+                fresh[i].next = slab[i].next;
+                fresh[i].chain = slab[i].chain;
+                fresh[i].hash = slab[i].hash;
+            }
+            for (std::uint32_t i = first; i != nil; i = slab[i].next) {
+                new (fresh[i].raw) value_type(std::move(*value_of(i)));
+                value_of(i)->~value_type();
+            }
+            ::operator delete(slab);
+            slab = fresh;
+            slots = n;
+        }
+        /**
+         * rebuild the bucket chains for n (a power of two) buckets,
+         * the entries stay where they are
+         */
+        void rehash(std::uint32_t n) {
+            delete[] buckets;
+            buckets = new std::uint32_t[n];
+            for (std::uint32_t b = 0; b < n; b++) buckets[b] = nil;
+            shift = 32;
+            while ((std::uint32_t(1) << (32 - shift)) < n) shift--;
+            for (std::uint32_t i = first; i != nil; i = slab[i].next) {
+                std::uint32_t &head = buckets[bucket_of(slab[i].hash)];
+                slab[i].chain = head;
+                head = i;
+            }
+        }
+
+        /**
+         * a slot for a new entry holding value, linked in as the newest
+         */
+        template <class V>
+        std::uint32_t emplace(std::uint32_t hash, V &&value) {
+            std::uint32_t i;
+            if (free_head != nil) {
+                i = free_head;
+                free_head = slab[i].chain;
+            } else {
+                if (top == slots) {
+                    if (slots == nil) {
+                        throw runtime_error();
+                    }
+                    grow_slab(slots ? (slots > 0x7fffffffu ? nil : slots * 2) : min_buckets);
+                }
+                i = top++;
+            }
+            new (slab[i].raw) value_type(std::forward<V>(value));
+            slab[i].hash = hash;
+            slab[i].prev = last;
+            slab[i].next = nil;
+            if (last != nil) slab[last].next = i;
+            else first = i;
+            last = i;
+            if (++count_ > n_buckets()) {
+                rehash(n_buckets() * 2);
+            } else {
+                std::uint32_t &head = buckets[bucket_of(hash)];
+                slab[i].chain = head;
+                head = i;
+            }
+            return i;
+        }
+
+        void unlink(std::uint32_t i) {
+            if (slab[i].prev != nil) slab[slab[i].prev].next = slab[i].next;
+            else first = slab[i].next;
+            if (slab[i].next != nil) slab[slab[i].next].prev = slab[i].prev;
+            else last = slab[i].prev;
+        }
+        void link_tail(std::uint32_t i) {
+            slab[i].prev = last;
+            slab[i].next = nil;
+            if (last != nil) slab[last].next = i;
+            else first = i;
+            last = i;
+        }
+
+        void destroy_all() {
+            for (std::uint32_t i = first; i != nil; i = slab[i].next) value_of(i)->~value_type();
+        }
+
+    public:
+        class const_iterator;
+        class iterator {
+            friend class compact_linked_hashmap<Key, T, Hash, Equal>;
+        public:
+            compact_linked_hashmap *map;
+            std::uint32_t index;
+
+            iterator() : map(nullptr), index(nil) {}
+            iterator(compact_linked_hashmap *map, std::uint32_t index) : map(map), index(index) {}
+
+            /**
+             * iter++
+             */
+            iterator operator++(int) {
+                iterator ret(*this);
+                ++*this;
+                return ret;
+            }
+            /**
+             * ++iter
+             */
+            iterator &operator++() {
+                if (!map || index == nil) {
+                    throw index_out_of_bound();
+                }
+                index = map->slab[index].next;
+                return *this;
+            }
+            /**
+             * iter--
+             */
+            iterator operator--(int) {
+                iterator ret(*this);
+                --*this;
+                return ret;
+            }
+            /**
+             * --iter
+             */
+            iterator &operator--() {
+                std::uint32_t prev = !map ? nil : index == nil ? map->last : map->slab[index].prev;
+                if (prev == nil) {
+                    throw index_out_of_bound();
+                }
+                index = prev;
+                return *this;
+            }
+
+            value_type &operator*() const {
+                if (!map || index == nil) {
+                    throw invalid_iterator();
+                }
+                return *map->value_of(index);
+            }
+            value_type *operator->() const {
+                return &**this;
+            }
+
+            bool operator==(const iterator &rhs) const {
+                return index == rhs.index;
+            }
+            bool operator!=(const iterator &rhs) const {
+                return index != rhs.index;
+            }
+            bool operator==(const const_iterator &rhs) const {
+                return index == rhs.index;
+            }
+            bool operator!=(const const_iterator &rhs) const {
+                return index != rhs.index;
+            }
+        };
+        class const_iterator {
+            friend class compact_linked_hashmap<Key, T, Hash, Equal>;
+        public:
+            const compact_linked_hashmap *map;
+            std::uint32_t index;
+
+            const_iterator() : map(nullptr), index(nil) {}
+            const_iterator(const compact_linked_hashmap *map, std::uint32_t index) : map(map), index(index) {}
+            const_iterator(const iterator &other) : map(other.map), index(other.index) {}
+
+            const_iterator operator++(int) {
+                const_iterator ret(*this);
+                ++*this;
+                return ret;
+            }
+            const_iterator &operator++() {
+                if (!map || index == nil) {
+                    throw index_out_of_bound();
+                }
+                index = map->slab[index].next;
+                return *this;
+            }
+            const_iterator operator--(int) {
+                const_iterator ret(*this);
+                --*this;
+                return ret;
+            }
+            const_iterator &operator--() {
+                std::uint32_t prev = !map ? nil : index == nil ? map->last : map->slab[index].prev;
+                if (prev == nil) {
+                    throw index_out_of_bound();
+                }
+                index = prev;
+                return *this;
+            }
+
+            const value_type &operator*() const {
+                if (!map || index == nil) {
+                    throw invalid_iterator();
+                }
+                return *map->value_of(index);
+            }
+            const value_type *operator->() const {
+                return &**this;
+            }
+
+            bool operator==(const iterator &rhs) const {
+                return index == rhs.index;
+            }
+            bool operator!=(const iterator &rhs) const {
+                return index != rhs.index;
+            }
+            bool operator==(const const_iterator &rhs) const {
+                return index == rhs.index;
+            }
+            bool operator!=(const const_iterator &rhs) const {
+                return index != rhs.index;
+            }
+        };
+
+        /**
+         * room for capacity entries up front
+         */
+        explicit compact_linked_hashmap(int capacity = 0)
+            : slab(nullptr), slots(0), top(0), free_head(nil), first(nil), last(nil),
+              buckets(nullptr), shift(32), count_(0) {
+            rehash(min_buckets);
+            reserve(capacity);
+        }
+        /**
+         * one pass over other's order, into a slab sized once
+         */
+        compact_linked_hashmap(const compact_linked_hashmap &other) : compact_linked_hashmap(other.size()) {
+            for (std::uint32_t i = other.first; i != nil; i = other.slab[i].next) {
+                emplace(other.slab[i].hash, *other.value_of(i));
+            }
+        }
+        /**
+         * steal the slab, other is left with min_buckets
+         * fresh buckets and is an empty map afterwards, which may throw
+         */
+        compact_linked_hashmap(compact_linked_hashmap &&other) : compact_linked_hashmap() {
+            swap(other);
+        }
+        compact_linked_hashmap &operator=(const compact_linked_hashmap &other) {
+            if (this == &other) return *this;
+            compact_linked_hashmap tmp(other);
+            swap(tmp);
+            return *this;
+        }
+        compact_linked_hashmap &operator=(compact_linked_hashmap &&other) noexcept {
+            swap(other);
+            return *this;
+        }
+        ~compact_linked_hashmap() {
+            destroy_all();
+            ::operator delete(slab);
+            delete[] buckets;
+        }
+        void swap(compact_linked_hashmap &other) noexcept {
+            std::swap(slab, other.slab);
+            std::swap(slots, other.slots);
+            std::swap(top, other.top);
+            std::swap(free_head, other.free_head);
+            std::swap(first, other.first);
+            std::swap(last, other.last);
+            std::swap(buckets, other.buckets);
+            std::swap(shift, other.shift);
+            std::swap(count_, other.count_);
+        }
+
+        /**
+         * make room for n entries, so that the next n - size
+         * insertions neither grow the slab nor rehash
+         */
+        void reserve(int n) {
+            if (n <= 0) return;
+            std::uint32_t need = static_cast<std::uint32_t>(n);
+            if (need > slots) grow_slab(need);
+            std::uint32_t b = n_buckets();
+            while (b < need) b *= 2;
+            if (b > n_buckets()) rehash(b);
+        }
+
+        /**
+         * call fn(value_pair) for every element in insertion order
+         * (oldest first). fn must not insert or remove.
+         */
+        template <class Fn>
+        void for_each(Fn fn) {
+            for (std::uint32_t i = first; i != nil; i = slab[i].next) fn(*value_of(i));
+        }
+        template <class Fn>
+        void for_each(Fn fn) const {
+            for (std::uint32_t i = first; i != nil; i = slab[i].next) fn(const_cast<const value_type &>(*value_of(i)));
+        }
+
+        /**
+         * return the value connected with the key,
+         * if the key not found, throw
+         */
+        T &at(const Key &key) {
+            std::uint32_t i = locate(key);
+            if (i == nil) {
+                throw index_out_of_bound();
+            }
+            return value_of(i)->second;
+        }
+        const T &at(const Key &key) const {
+            std::uint32_t i = locate(key);
+            if (i == nil) {
+                throw index_out_of_bound();
+            }
+            return value_of(i)->second;
+        }
+        template <class K, enable_if_transparent<K, Key, Hash, Equal> = 0>
+        T &at(const K &key) {
+            std::uint32_t i = locate(key);
+            if (i == nil) {
+                throw index_out_of_bound();
+            }
+            return value_of(i)->second;
+        }
+        template <class K, enable_if_transparent<K, Key, Hash, Equal> = 0>
+        const T &at(const K &key) const {
+            std::uint32_t i = locate(key);
+            if (i == nil) {
+                throw index_out_of_bound();
+            }
+            return value_of(i)->second;
+        }
+        T &operator[](const Key &key) {
+            return at(key);
+        }
+        const T &operator[](const Key &key) const {
+            return at(key);
+        }
+
+        iterator begin() {
+            return iterator(this, first);
+        }
+        const_iterator cbegin() const {
+            return const_iterator(this, first);
+        }
+        iterator end() {
+            return iterator(this, nil);
+        }
+        const_iterator cend() const {
+            return const_iterator(this, nil);
+        }
+        bool empty() const {
+            return count_ == 0;
+        }
+        size_t size() const {
+            return count_;
+        }
+
+        /**
+         * drop every entry, the slab and buckets are kept for reuse
+         */
+        void clear() {
+            destroy_all();
+            top = count_ = 0;
+            free_head = first = last = nil;
+            for (std::uint32_t b = 0; b < n_buckets(); b++) buckets[b] = nil;
+        }
+
+        /**
+         * insert the value_pair as the newest element and return true,
+         * or, if the key exists, update its value, make it the newest
+         * and return false
+         */
+        pair<iterator, bool> insert(const value_type &value) {
+            std::uint32_t i = locate(value.first);
+            if (i != nil) {
+                value_of(i)->second = value.second;
+                unlink(i);
+                link_tail(i);
+                return pair<iterator, bool>(iterator(this, i), false);
+            }
+            return pair<iterator, bool>(iterator(this, emplace(hash_of(value.first), value)), true);
+        }
+        /**
+         * append a value_pair whose key is known to be absent,
+         * no lookup
+         */
+        iterator insert_unique(value_type &&value) {
+            std::uint32_t hash = hash_of(value.first);
+            return iterator(this, emplace(hash, std::move(value)));
+        }
+
+        /**
+         * move the value_pair pointed by the iterator to the newest end
+         */
+        void touch(iterator pos) {
+            unlink(pos.index);
+            link_tail(pos.index);
+        }
+        /**
+         * erase the value_pair pointed by the iterator,
+         * its slot goes to the free list
+         */
+        void remove(iterator pos) {
+            std::uint32_t i = pos.index;
+            if (i == nil) {
+                throw invalid_iterator();
+            }
+            std::uint32_t *link = &buckets[bucket_of(slab[i].hash)];
+            while (*link != i) link = &slab[*link].chain;
+            *link = slab[i].chain;
+            unlink(i);
+            value_of(i)->~value_type();
+            slab[i].chain = free_head;
+            free_head = i;
+            count_--;
+        }
+
+        size_t count(const Key &key) const {
+            return locate(key) != nil;
+        }
+        template <class K, enable_if_transparent<K, Key, Hash, Equal> = 0>
+        size_t count(const K &key) const {
+            return locate(key) != nil;
+        }
+        iterator find(const Key &key) {
+            return iterator(this, locate(key));
+        }
+        template <class K, enable_if_transparent<K, Key, Hash, Equal> = 0>
+        iterator find(const K &key) {
+            return iterator(this, locate(key));
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,425 @@
+#ifndef SJTU_CONCURRENT_HASHMAP_HPP
+#define SJTU_CONCURRENT_HASHMAP_HPP
+
+#include "lru.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace sjtu {
+    /**
+     * epoch-based reclamation.
+     * a reader enters by bumping the counter of its own slot for the parity
+     * of the global epoch and leaves by dropping it again: it never waits
+     * and only writes to its own cache line.
+     * a writer retires what it unlinked with the current epoch. the epoch
+     * only moves from e to e + 1 once no reader of e - 1 is left, so two
+     * epochs later nobody can still hold the retired object.
+     */
+    class epoch_domain {
+        static const size_t n_slots = 64;
+        struct alignas(64) slot {
+            std::atomic<size_t> readers[2];
+            slot() {
+                readers[0].store(0, std::memory_order_relaxed);
+                readers[1].store(0, std::memory_order_relaxed);
+            }
+        };
+        struct retired {
+            std::uint64_t epoch;
+            void *ptr;
+            void (*destroy)(void *);
+        };
+
+        std::atomic<std::uint64_t> epoch;
+        slot slots[n_slots];
+        std::vector<retired> garbage;
+
+        /**
+         * threads sharing a slot only share its counters,
+         * which stays correct
+         */
+        static size_t thread_slot() {
+            static std::atomic<size_t> next(0);
+            static thread_local size_t index = next++ % n_slots;
+            return index;
+        }
+        template <class U>
+        static void destroy(void *ptr) {
+            delete static_cast<U *>(ptr);
+        }
+
+        /**
+         * move to the next epoch if no reader of the previous one is left
+         */
+        bool try_advance() {
+            std::uint64_t now = epoch.load();
+            for (size_t i = 0; i < n_slots; i++) {
+                if (slots[i].readers[(now + 1) & 1].load() != 0) return false;
+            }
+            epoch.store(now + 1);
+            return true;
+        }
+
+    public:
+        /**
+         * keeps everything reachable when it was built alive
+         * until it is destroyed
+         */
+        class guard {
+            std::atomic<size_t> *counter;
+
+        public:
+            explicit guard(epoch_domain &domain) {
+                slot &s = domain.slots[thread_slot()];
+                for (;;) {
+                    std::uint64_t now = domain.epoch.load();
+                    counter = &s.readers[now & 1];
+                    counter->fetch_add(1);
+                    if (domain.epoch.load() == now) return;
+                    counter->fetch_sub(1);
+                }
+            }
+            guard(const guard &other) = delete;
+            guard &operator=(const guard &other) = delete;
+            ~guard() {
+                counter->fetch_sub(1, std::memory_order_release);
+            }
+        };
+
+        epoch_domain() : epoch(0) {}
+        epoch_domain(const epoch_domain &other) = delete;
+        epoch_domain &operator=(const epoch_domain &other) = delete;
+        /**
+         * no reader may be left
+         */
+        ~epoch_domain() {
+            for (auto &r : garbage) r.destroy(r.ptr);
+        }
+
+        /**
+         * delete ptr once no reader can see it any more,
+         * writers only (they must be serialized)
+         */
+        template <class U>
+        void retire(U *ptr) {
+            garbage.push_back(retired{epoch.load(), ptr, &destroy<U>});
+            if (garbage.size() >= 64) collect();
+        }
+
+        /**
+         * free whatever is old enough, writers only
+         */
+        void collect() {
+            try_advance();
+            try_advance();
+            std::uint64_t now = epoch.load();
+            size_t kept = 0;
+            for (size_t i = 0; i < garbage.size(); i++) {
+                if (garbage[i].epoch + 2 <= now) garbage[i].destroy(garbage[i].ptr);
+                else garbage[kept++] = garbage[i];
+            }
+            garbage.resize(kept);
+        }
+    };
+
+    /**
+     * a linked hashmap for read-mostly use: find(), count() and visit()
+     * are lock-free and never write to shared memory, while writers are
+     * serialized by a mutex.
+     * buckets are published through atomic pointers, and a node is never
+     * changed once readers can reach it: an update links a new node in
+     * its place, a resize builds a new table. unlinked nodes and tables
+     * are retired through an epoch_domain instead of being deleted.
+     * the insertion order (oldest first) is kept for eviction,
+     * it is only seen by writers.
+     */
+    template <
+        class Key,
+        class T,
+        class Hash = std::hash<Key>,
+        class Equal = std::equal_to<Key> >
+    class concurrent_hashmap {
+    public:
+        typedef pair<const Key, T> value_type;
+
+    private:
+        struct entry {
+            value_type value;
+            entry *prev;
+            entry *next;
+            explicit entry(const value_type &value) : value(value), prev(nullptr), next(nullptr) {}
+        };
+        struct chain {
+            entry *item;
+            size_t hash;
+            std::atomic<chain *> next;
+            chain(entry *item, size_t hash, chain *next) : item(item), hash(hash), next(next) {}
+        };
+        struct table {
+            size_t capacity;    // a power of two
+            std::atomic<chain *> *buckets;
+            explicit table(size_t capacity) : capacity(capacity), buckets(new std::atomic<chain *>[capacity]) {
+                for (size_t i = 0; i < capacity; i++) buckets[i].store(nullptr, std::memory_order_relaxed);
+            }
+            table(const table &other) = delete;
+            table &operator=(const table &other) = delete;
+            ~table() {
+                delete[] buckets;
+            }
+            std::atomic<chain *> &bucket(size_t hash) const {
+                return buckets[hash & (capacity - 1)];
+            }
+        };
+
+        mutable epoch_domain domain;
+        std::atomic<table *> current;
+        std::atomic<size_t> count_;
+        double load_factor;
+        std::mutex writer;
+        entry *oldest;
+        entry *newest;
+
+        template <class K, class Fn>
+        bool visit_as(const K &key, Fn &fn) const {
+            epoch_domain::guard guard(domain);
+            size_t hash = Hash()(key);
+            table *t = current.load(std::memory_order_acquire);
+            for (chain *c = t->bucket(hash).load(std::memory_order_acquire); c;
+                 c = c->next.load(std::memory_order_acquire)) {
+                if (c->hash == hash && Equal()(c->item->value.first, key)) {
+                    fn(const_cast<const value_type &>(c->item->value));
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * the atomic pointing at the chain of key (or at the null
+         * ending its bucket), writers only
+         */
+        std::atomic<chain *> *locate(const Key &key, size_t hash) const {
+            std::atomic<chain *> *link = &current.load(std::memory_order_relaxed)->bucket(hash);
+            for (chain *c = link->load(std::memory_order_relaxed); c; c = link->load(std::memory_order_relaxed)) {
+                if (c->hash == hash && Equal()(c->item->value.first, key)) break;
+                link = &c->next;
+            }
+            return link;
+        }
+
+        void link_newest(entry *e) {
+            e->prev = newest;
+            e->next = nullptr;
+            if (newest) newest->next = e;
+            else oldest = e;
+            newest = e;
+        }
+        void unlink_entry(entry *e) {
+            if (e->prev) e->prev->next = e->next;
+            else oldest = e->next;
+            if (e->next) e->next->prev = e->prev;
+            else newest = e->prev;
+        }
+
+        /**
+         * publish a table twice as large, built from new chains
+         */
+        void grow() {
+            table *old = current.load(std::memory_order_relaxed);
+            table *t = new table(old->capacity * 2);
+            for (size_t i = 0; i < old->capacity; i++) {
+                for (chain *c = old->buckets[i].load(std::memory_order_relaxed); c;
+                     c = c->next.load(std::memory_order_relaxed)) {
+                    std::atomic<chain *> &b = t->bucket(c->hash);
+                    b.store(new chain(c->item, c->hash, b.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+                }
+            }
+            current.store(t, std::memory_order_release);
+            retire_table(old, false);
+        }
+
+        void retire_table(table *t, bool entries) {
+            for (size_t i = 0; i < t->capacity; i++) {
+                chain *c = t->buckets[i].load(std::memory_order_relaxed);
+                while (c) {
+                    chain *next = c->next.load(std::memory_order_relaxed);
+                    if (entries) domain.retire(c->item);
+                    domain.retire(c);
+                    c = next;
+                }
+            }
+            domain.retire(t);
+        }
+
+        /**
+         * unlink the chain *link points at and retire it with its entry
+         */
+        void erase(std::atomic<chain *> *link) {
+            chain *c = link->load(std::memory_order_relaxed);
+            link->store(c->next.load(std::memory_order_relaxed), std::memory_order_release);
+            unlink_entry(c->item);
+            domain.retire(c->item);
+            domain.retire(c);
+            count_.store(count_.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+        }
+
+    public:
+        /**
+         * capacity is rounded up to a power of two
+         */
+        explicit concurrent_hashmap(size_t capacity = 16, double load_factor = 0.75)
+            : count_(0), load_factor(load_factor), oldest(nullptr), newest(nullptr) {
+            size_t c = 1;
+            while (c < capacity) c <<= 1;
+            current.store(new table(c), std::memory_order_relaxed);
+        }
+        concurrent_hashmap(const concurrent_hashmap &other) = delete;
+        concurrent_hashmap &operator=(const concurrent_hashmap &other) = delete;
+        /**
+         * no reader may be left
+         */
+        ~concurrent_hashmap() {
+            table *t = current.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < t->capacity; i++) {
+                chain *c = t->buckets[i].load(std::memory_order_relaxed);
+                while (c) {
+                    chain *next = c->next.load(std::memory_order_relaxed);
+                    delete c->item;
+                    delete c;
+                    c = next;
+                }
+            }
+            delete t;
+        }
+
+        size_t size() const {
+            return count_.load(std::memory_order_relaxed);
+        }
+        bool empty() const {
+            return size() == 0;
+        }
+
+        /**
+         * call fn(value_pair) if key exists and return true, lock-free.
+         * the value_pair must not be used after fn returns
+         */
+        template <class Fn>
+        bool visit(const Key &key, Fn fn) const {
+            return visit_as(key, fn);
+        }
+        /**
+         * copy the value connected with key into out, lock-free,
+         * return false if not found
+         */
+        bool find(const Key &key, T &out) const {
+            auto copy = [&out](const value_type &value) { out = value.second; };
+            return visit_as(key, copy);
+        }
+        size_t count(const Key &key) const {
+            auto nothing = [](const value_type &) {};
+            return visit_as(key, nothing);
+        }
+        /**
+         * the same with any key-like K, if Hash and Equal are transparent
+         */
+        template <class K, enable_if_transparent<K, Key, Hash, Equal> = 0>
+        bool find(const K &key, T &out) const {
+            auto copy = [&out](const value_type &value) { out = value.second; };
+            return visit_as(key, copy);
+        }
+        template <class K, enable_if_transparent<K, Key, Hash, Equal> = 0>
+        size_t count(const K &key) const {
+            auto nothing = [](const value_type &) {};
+            return visit_as(key, nothing);
+        }
+
+        /**
+         * insert the value_pair as the newest one, or replace
+         * the existing value (and make it the newest)
+         * return true if the key was new
+         */
+        bool insert(const value_type &value) {
+            std::lock_guard<std::mutex> lock(writer);
+            size_t hash = Hash()(value.first);
+            std::atomic<chain *> *link = locate(value.first, hash);
+            entry *e = new entry(value);
+            if (chain *old = link->load(std::memory_order_relaxed)) {
+                link->store(new chain(e, hash, old->next.load(std::memory_order_relaxed)), std::memory_order_release);
+                unlink_entry(old->item);
+                link_newest(e);
+                domain.retire(old->item);
+                domain.retire(old);
+                return false;
+            }
+            table *t = current.load(std::memory_order_relaxed);
+            if (size() + 1 > t->capacity * load_factor) {
+                grow();
+                t = current.load(std::memory_order_relaxed);
+            }
+            std::atomic<chain *> &b = t->bucket(hash);
+            b.store(new chain(e, hash, b.load(std::memory_order_relaxed)), std::memory_order_release);
+            link_newest(e);
+            count_.store(size() + 1, std::memory_order_relaxed);
+            return true;
+        }
+
+        /**
+         * the value_pair exists, remove and return true
+         * otherwise, return false
+         */
+        bool remove(const Key &key) {
+            std::lock_guard<std::mutex> lock(writer);
+            std::atomic<chain *> *link = locate(key, Hash()(key));
+            if (!link->load(std::memory_order_relaxed)) return false;
+            erase(link);
+            return true;
+        }
+
+        /**
+         * remove the oldest value_pair, return false if empty
+         */
+        bool remove_oldest() {
+            std::lock_guard<std::mutex> lock(writer);
+            if (!oldest) return false;
+            erase(locate(oldest->value.first, Hash()(oldest->value.first)));
+            return true;
+        }
+
+        /**
+         * make the value_pair of key the newest one,
+         * return false if not found
+         */
+        bool touch(const Key &key) {
+            std::lock_guard<std::mutex> lock(writer);
+            chain *c = locate(key, Hash()(key))->load(std::memory_order_relaxed);
+            if (!c) return false;
+            unlink_entry(c->item);
+            link_newest(c->item);
+            return true;
+        }
+
+        void clear() {
+            std::lock_guard<std::mutex> lock(writer);
+            table *old = current.load(std::memory_order_relaxed);
+            current.store(new table(old->capacity), std::memory_order_release);
+            retire_table(old, true);
+            oldest = newest = nullptr;
+            count_.store(0, std::memory_order_relaxed);
+        }
+
+        /**
+         * call fn(value_pair) oldest first, holding the writer lock
+         */
+        template <class Fn>
+        void for_each(Fn fn) {
+            std::lock_guard<std::mutex> lock(writer);
+            for (entry *e = oldest; e; e = e->next) fn(const_cast<const value_type &>(e->value));
+        }
+    };
+}
+
+#endif
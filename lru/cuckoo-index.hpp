@@ -0,0 +1,479 @@
+#ifndef SJTU_CUCKOO_INDEX_HPP
+#define SJTU_CUCKOO_INDEX_HPP
+
+#include "concurrent-hashmap.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+
+namespace sjtu {
+    /**
+     * a concurrent bucketized cuckoo hash index for many writers.
+     * every key lives in one of the 4 slots of its two candidate buckets.
+     * buckets map onto a fixed set of lock stripes, each a version counter
+     * that is odd while a writer holds it:
+     * - a reader copies the two buckets of its key without locking and
+     *   keeps the copy only if neither stripe moved meanwhile
+     * - a writer locks the stripes of its two buckets (lower one first);
+     *   if both buckets are full, a breadth-first search finds the
+     *   shortest path of keys to shift to their other bucket, and each
+     *   shift locks just the two stripes it touches
+     * - when no path is found the table doubles under every stripe, the
+     *   old one is retired through an epoch_domain, which readers and
+     *   writers both enter
+     * Key and T are copied with plain atomic loads, so both must be
+     * trivially copyable (e.g. an int key and an entry pointer).
+     */
+    template <
+        class Key,
+        class T,
+        class Hash = std::hash<Key>,
+        class Equal = std::equal_to<Key> >
+    class cuckoo_index {
+        static_assert(std::is_trivially_copyable<Key>::value, "Key must be trivially copyable");
+        static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+
+        static const size_t n_ways = 4;
+        static const size_t n_stripes = 2048;   // a power of two
+        static const size_t max_depth = 5;      // shifts per cuckoo path
+        static const size_t max_search = 512;   // buckets visited per search
+
+        struct slot {
+            std::atomic<bool> used;
+            std::atomic<Key> key;
+            std::atomic<T> value;
+        };
+        struct bucket {
+            slot slots[n_ways];
+        };
+        struct table {
+            size_t mask;        // buckets - 1, a power of two
+            bucket *buckets;
+            explicit table(size_t n) : mask(n - 1), buckets(new bucket[n]) {
+                for (size_t b = 0; b < n; b++) {
+                    for (size_t s = 0; s < n_ways; s++) buckets[b].slots[s].used.store(false, std::memory_order_relaxed);
+                }
+            }
+            table(const table &other) = delete;
+            table &operator=(const table &other) = delete;
+            ~table() {
+                delete[] buckets;
+            }
+        };
+        struct alignas(64) stripe {
+            std::atomic<std::uint64_t> version;     // odd while locked
+            std::atomic<std::int64_t> count;        // keys whose lower stripe this is
+        };
+
+        mutable epoch_domain domain;
+        std::atomic<table *> current;
+        stripe stripes[n_stripes];
+
+        struct place {
+            size_t first;
+            size_t second;
+        };
+        static std::uint64_t mix(std::uint64_t hash) {
+            hash ^= hash >> 33;
+            hash *= 0xff51afd7ed558ccdULL;
+            hash ^= hash >> 33;
+            hash *= 0xc4ceb9fe1a85ec53ULL;
+            hash ^= hash >> 33;
+            return hash;
+        }
+        /**
+         * the two buckets of key, they differ unless the table has one
+         */
+        static place buckets_of(const Key &key, size_t mask) {
+            std::uint64_t h = mix(Hash()(key));
+            size_t first = h & mask;
+            return place{first, (first ^ ((h >> 32) | 1)) & mask};
+        }
+        static size_t stripe_of(size_t b) {
+            return b & (n_stripes - 1);
+        }
+
+        void lock(size_t s) {
+            for (;;) {
+                std::uint64_t v = stripes[s].version.load(std::memory_order_relaxed);
+                if (!(v & 1) && stripes[s].version.compare_exchange_weak(v, v + 1, std::memory_order_acquire)) break;
+                std::this_thread::yield();
+            }
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+        void unlock(size_t s) {
+            stripes[s].version.fetch_add(1, std::memory_order_release);
+        }
+        /**
+         * lock the stripes of buckets a and b in order,
+         * return false (holding nothing) if the table changed first
+         */
+        bool lock_pair(table *t, size_t a, size_t b) {
+            size_t lo = stripe_of(a), hi = stripe_of(b);
+            if (lo > hi) std::swap(lo, hi);
+            lock(lo);
+            if (hi != lo) lock(hi);
+            if (current.load(std::memory_order_acquire) == t) return true;
+            unlock_pair(a, b);
+            return false;
+        }
+        void unlock_pair(size_t a, size_t b) {
+            size_t lo = stripe_of(a), hi = stripe_of(b);
+            if (hi != lo) unlock(hi);
+            unlock(lo);
+        }
+        void lock_all() {
+            for (size_t s = 0; s < n_stripes; s++) lock(s);
+        }
+        void unlock_all() {
+            for (size_t s = n_stripes; s-- > 0;) unlock(s);
+        }
+        stripe &owner(const place &p) {
+            size_t a = stripe_of(p.first), b = stripe_of(p.second);
+            return stripes[a < b ? a : b];
+        }
+
+        /**
+         * the slot of key in bucket b, or of a free one if free,
+         * nullptr if neither
+         */
+        static slot *scan(bucket &b, const Key &key, slot **free) {
+            for (size_t s = 0; s < n_ways; s++) {
+                slot &x = b.slots[s];
+                if (!x.used.load(std::memory_order_relaxed)) {
+                    if (free && !*free) *free = &x;
+                } else if (Equal()(x.key.load(std::memory_order_relaxed), key)) {
+                    return &x;
+                }
+            }
+            return nullptr;
+        }
+        static void fill(slot &x, const Key &key, const T &value) {
+            x.key.store(key, std::memory_order_relaxed);
+            x.value.store(value, std::memory_order_relaxed);
+            x.used.store(true, std::memory_order_relaxed);
+        }
+
+        /**
+         * copy the value of key out of t if both stripes held still
+         * meanwhile. return 1 if found, 0 if not, -1 to try again
+         */
+        int try_read(table *t, const Key &key, T *out) const {
+            place p = buckets_of(key, t->mask);
+            const stripe &a = stripes[stripe_of(p.first)], &b = stripes[stripe_of(p.second)];
+            std::uint64_t va = a.version.load(std::memory_order_acquire);
+            std::uint64_t vb = b.version.load(std::memory_order_acquire);
+            if ((va | vb) & 1) return -1;
+            int found = 0;
+            T value = T();
+            for (size_t i = 0; i < 2 && !found; i++) {
+                bucket &bk = t->buckets[i ? p.second : p.first];
+                for (size_t s = 0; s < n_ways; s++) {
+                    slot &x = bk.slots[s];
+                    if (x.used.load(std::memory_order_relaxed) && Equal()(x.key.load(std::memory_order_relaxed), key)) {
+                        value = x.value.load(std::memory_order_relaxed);
+                        found = 1;
+                        break;
+                    }
+                }
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (a.version.load(std::memory_order_relaxed) != va || b.version.load(std::memory_order_relaxed) != vb
+                || current.load(std::memory_order_relaxed) != t) {
+                return -1;
+            }
+            if (found && out) *out = value;
+            return found;
+        }
+
+        bool read(const Key &key, T *out) const {
+            epoch_domain::guard guard(domain);
+            for (;;) {
+                int found = try_read(current.load(std::memory_order_acquire), key, out);
+                if (found >= 0) return found;
+                std::this_thread::yield();
+            }
+        }
+
+        /**
+         * a step of a cuckoo path: the key in slot of parent's bucket
+         * goes to bucket
+         */
+        struct step {
+            size_t bucket;
+            int parent;
+            size_t slot;
+        };
+
+        /**
+         * free a slot in bucket first or second of t by shifting keys
+         * along the shortest path found, return false if there is none
+         * or it went stale (the caller starts over either way, but only
+         * false with stale == false calls for a larger table)
+         */
+        bool make_room(table *t, const place &p, bool &stale) {
+            step queue[max_search];
+            size_t head = 0, tail = 0;
+            queue[tail++] = step{p.first, -1, 0};
+            queue[tail++] = step{p.second, -1, 0};
+            int end = -1;
+            size_t end_slot = 0;
+            while (head < tail && end < 0) {
+                int cur = static_cast<int>(head++);
+                bucket &b = t->buckets[queue[cur].bucket];
+                size_t depth = 0;
+                for (int q = cur; queue[q].parent >= 0; q = queue[q].parent) depth++;
+                for (size_t s = 0; s < n_ways; s++) {
+                    slot &x = b.slots[s];
+                    if (!x.used.load(std::memory_order_relaxed)) {
+                        end = cur;
+                        end_slot = s;
+                        break;
+                    }
+                    if (depth >= max_depth || tail >= max_search) continue;
+                    place alt = buckets_of(x.key.load(std::memory_order_relaxed), t->mask);
+                    size_t to = alt.first == queue[cur].bucket ? alt.second : alt.first;
+                    queue[tail++] = step{to, cur, s};
+                }
+            }
+            stale = false;
+            if (end < 0) return false;
+            // shift from the free end back to the root
+            for (int q = end; queue[q].parent >= 0; q = queue[q].parent) {
+                size_t from = queue[queue[q].parent].bucket, to = queue[q].bucket;
+                if (!lock_pair(t, from, to)) {
+                    stale = true;
+                    return false;
+                }
+                slot &src = t->buckets[from].slots[queue[q].slot];
+                slot &dst = t->buckets[to].slots[end_slot];
+                bool ok = src.used.load(std::memory_order_relaxed) && !dst.used.load(std::memory_order_relaxed);
+                if (ok) {
+                    Key key = src.key.load(std::memory_order_relaxed);
+                    place alt = buckets_of(key, t->mask);
+                    ok = (alt.first == from && alt.second == to) || (alt.first == to && alt.second == from);
+                    if (ok) {
+                        fill(dst, key, src.value.load(std::memory_order_relaxed));
+                        src.used.store(false, std::memory_order_relaxed);
+                    }
+                }
+                unlock_pair(from, to);
+                if (!ok) {
+                    stale = true;
+                    return false;
+                }
+                end_slot = queue[q].slot;
+            }
+            return true;
+        }
+
+        /**
+         * put key into t, which nobody else can see or write,
+         * by a random walk of evictions. false if it gave up,
+         * t is then short of a key and must be dropped
+         */
+        static bool place_alone(table *t, Key key, T value) {
+            std::uint64_t seed = mix(reinterpret_cast<std::uintptr_t>(t));
+            place p = buckets_of(key, t->mask);
+            size_t b = p.first;
+            for (int kicks = 0; kicks < 1000; kicks++) {
+                slot *free = nullptr;
+                scan(t->buckets[p.first], key, &free);
+                if (!free) scan(t->buckets[p.second], key, &free);
+                if (free) {
+                    fill(*free, key, value);
+                    return true;
+                }
+                seed = mix(seed + kicks);
+                slot &victim = t->buckets[b].slots[seed % n_ways];
+                Key k = victim.key.load(std::memory_order_relaxed);
+                T v = victim.value.load(std::memory_order_relaxed);
+                fill(victim, key, value);
+                key = k;
+                value = v;
+                p = buckets_of(key, t->mask);
+                b = p.first == b ? p.second : p.first;
+            }
+            return false;
+        }
+
+        /**
+         * double the table holding every stripe, unless t was
+         * replaced already
+         */
+        void grow(table *t) {
+            lock_all();
+            if (current.load(std::memory_order_relaxed) == t) {
+                for (size_t n = (t->mask + 1) * 2;; n *= 2) {
+                    table *bigger = new table(n);
+                    bool ok = true;
+                    for (size_t b = 0; b <= t->mask && ok; b++) {
+                        for (size_t s = 0; s < n_ways && ok; s++) {
+                            slot &x = t->buckets[b].slots[s];
+                            if (!x.used.load(std::memory_order_relaxed)) continue;
+                            ok = place_alone(bigger, x.key.load(std::memory_order_relaxed),
+                                             x.value.load(std::memory_order_relaxed));
+                        }
+                    }
+                    if (!ok) {
+                        delete bigger;
+                        continue;
+                    }
+                    recount(bigger);
+                    current.store(bigger, std::memory_order_release);
+                    // a grow retires one table, far from the batch retire()
+                    // waits for, so the old tables are freed here
+                    domain.retire(t);
+                    domain.collect();
+                    break;
+                }
+            }
+            unlock_all();
+        }
+        /**
+         * give every key to its lower stripe again, under every stripe
+         */
+        void recount(table *t) {
+            for (size_t s = 0; s < n_stripes; s++) stripes[s].count.store(0, std::memory_order_relaxed);
+            for (size_t b = 0; b <= t->mask; b++) {
+                for (size_t s = 0; s < n_ways; s++) {
+                    slot &x = t->buckets[b].slots[s];
+                    if (!x.used.load(std::memory_order_relaxed)) continue;
+                    owner(buckets_of(x.key.load(std::memory_order_relaxed), t->mask)).count.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+
+    public:
+        /**
+         * room for about capacity keys before the first grow
+         */
+        explicit cuckoo_index(size_t capacity = 64) {
+            size_t n = 1;
+            while (n * n_ways * 9 < capacity * 10) n <<= 1;
+            current.store(new table(n), std::memory_order_relaxed);
+            for (size_t s = 0; s < n_stripes; s++) {
+                stripes[s].version.store(0, std::memory_order_relaxed);
+                stripes[s].count.store(0, std::memory_order_relaxed);
+            }
+        }
+        cuckoo_index(const cuckoo_index &other) = delete;
+        cuckoo_index &operator=(const cuckoo_index &other) = delete;
+        /**
+         * no reader or writer may be left
+         */
+        ~cuckoo_index() {
+            delete current.load(std::memory_order_relaxed);
+        }
+
+        size_t size() const {
+            std::int64_t n = 0;
+            for (size_t s = 0; s < n_stripes; s++) n += stripes[s].count.load(std::memory_order_relaxed);
+            return n > 0 ? static_cast<size_t>(n) : 0;
+        }
+        bool empty() const {
+            return size() == 0;
+        }
+        /**
+         * the number of slots
+         */
+        size_t capacity() const {
+            return (current.load(std::memory_order_acquire)->mask + 1) * n_ways;
+        }
+
+        /**
+         * copy the value connected with key into out, without locking,
+         * return false if not found
+         */
+        bool find(const Key &key, T &out) const {
+            return read(key, &out);
+        }
+        size_t count(const Key &key) const {
+            return read(key, nullptr);
+        }
+
+        /**
+         * insert the key, or replace the value of an existing one,
+         * return true if the key was new
+         */
+        bool insert(const Key &key, const T &value) {
+            epoch_domain::guard guard(domain);
+            for (;;) {
+                table *t = current.load(std::memory_order_acquire);
+                place p = buckets_of(key, t->mask);
+                if (!lock_pair(t, p.first, p.second)) continue;
+                slot *free = nullptr;
+                slot *found = scan(t->buckets[p.first], key, &free);
+                if (!found) found = scan(t->buckets[p.second], key, &free);
+                if (found) {
+                    found->value.store(value, std::memory_order_relaxed);
+                    unlock_pair(p.first, p.second);
+                    return false;
+                }
+                if (free) {
+                    fill(*free, key, value);
+                    owner(p).count.fetch_add(1, std::memory_order_relaxed);
+                    unlock_pair(p.first, p.second);
+                    return true;
+                }
+                unlock_pair(p.first, p.second);
+                bool stale;
+                if (!make_room(t, p, stale) && !stale) grow(t);
+            }
+        }
+
+        /**
+         * the key exists, remove it and return true
+         * otherwise, return false
+         */
+        bool remove(const Key &key) {
+            epoch_domain::guard guard(domain);
+            for (;;) {
+                table *t = current.load(std::memory_order_acquire);
+                place p = buckets_of(key, t->mask);
+                if (!lock_pair(t, p.first, p.second)) continue;
+                slot *found = scan(t->buckets[p.first], key, nullptr);
+                if (!found) found = scan(t->buckets[p.second], key, nullptr);
+                if (found) {
+                    found->used.store(false, std::memory_order_relaxed);
+                    owner(p).count.fetch_sub(1, std::memory_order_relaxed);
+                }
+                unlock_pair(p.first, p.second);
+                return found != nullptr;
+            }
+        }
+
+        void clear() {
+            lock_all();
+            table *t = current.load(std::memory_order_relaxed);
+            for (size_t b = 0; b <= t->mask; b++) {
+                for (size_t s = 0; s < n_ways; s++) t->buckets[b].slots[s].used.store(false, std::memory_order_relaxed);
+            }
+            for (size_t s = 0; s < n_stripes; s++) stripes[s].count.store(0, std::memory_order_relaxed);
+            unlock_all();
+        }
+
+        /**
+         * call fn(key, value) for every key, holding every stripe
+         */
+        template <class Fn>
+        void for_each(Fn fn) {
+            lock_all();
+            table *t = current.load(std::memory_order_relaxed);
+            for (size_t b = 0; b <= t->mask; b++) {
+                for (size_t s = 0; s < n_ways; s++) {
+                    slot &x = t->buckets[b].slots[s];
+                    if (x.used.load(std::memory_order_relaxed)) {
+                        fn(x.key.load(std::memory_order_relaxed), x.value.load(std::memory_order_relaxed));
+                    }
+                }
+            }
+            unlock_all();
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef SJTU_EVICTION_QUEUE_HPP
+#define SJTU_EVICTION_QUEUE_HPP
+
+#include "lru.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sjtu {
+    /**
+     * an eviction_listener that moves every batch into a queue and lets
+     * a background thread deliver it to target, in order, so the lru
+     * never waits for the write-back
+     */
+    class async_eviction_listener : public eviction_listener {
+        eviction_listener &target;
+        std::mutex lock;
+        std::condition_variable ready;
+        std::condition_variable idle;
+        std::deque<std::vector<eviction> > queue;
+        size_t busy;
+        bool stopping;
+        std::thread worker;
+
+        void run() {
+            std::unique_lock<std::mutex> guard(lock);
+            for (;;) {
+                ready.wait(guard, [this] { return stopping || !queue.empty(); });
+                if (queue.empty()) return;
+                std::vector<eviction> batch = std::move(queue.front());
+                queue.pop_front();
+                busy++;
+                guard.unlock();
+                target.on_evict(batch.data(), batch.size());
+                batch.clear();
+                guard.lock();
+                busy--;
+                if (queue.empty() && !busy) idle.notify_all();
+            }
+        }
+
+    public:
+        /**
+         * target is called on the background thread only
+         */
+        explicit async_eviction_listener(eviction_listener &target)
+            : target(target), busy(0), stopping(false), worker(&async_eviction_listener::run, this) {}
+        async_eviction_listener(const async_eviction_listener &other) = delete;
+        async_eviction_listener &operator=(const async_eviction_listener &other) = delete;
+        /**
+         * deliver everything queued, then stop
+         */
+        ~async_eviction_listener() {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                stopping = true;
+            }
+            ready.notify_one();
+            worker.join();
+        }
+
+        void on_evict(eviction *batch, size_t n) override {
+            std::vector<eviction> moved;
+            moved.reserve(n);
+            for (size_t i = 0; i < n; i++) moved.push_back(std::move(batch[i]));
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                queue.push_back(std::move(moved));
+            }
+            ready.notify_one();
+        }
+
+        /**
+         * wait until every queued batch has been delivered
+         */
+        void drain() {
+            std::unique_lock<std::mutex> guard(lock);
+            idle.wait(guard, [this] { return queue.empty() && !busy; });
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef SJTU_FRONT_CACHE_HPP
+#define SJTU_FRONT_CACHE_HPP
+
+#include "lru.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace sjtu {
+    /**
+     * a tiny set-associative cache of handles to the hottest values of an
+     * lru shared between threads and guarded by a mutex. it belongs to one
+     * thread, so keep one per thread (e.g. thread_local).
+     * an entry stays valid while the version stripe of its key is the one
+     * it was filled under, so a hit reads that stripe and nothing else
+     * shared. a miss goes to the lru under the mutex, and so does every
+     * refresh-th hit on an entry, to keep hot keys fresh in the lru order.
+     */
+    template <size_t Sets = 64, size_t Ways = 4>
+    class front_cache {
+        static_assert(Sets > 0 && (Sets & (Sets - 1)) == 0, "Sets must be a power of two");
+
+        struct way {
+            bool used;
+            int key;
+            std::uint32_t version;
+            std::uint32_t hits;
+            std::uint64_t stamp;    // last use, the smallest one in a set is replaced
+            Matrix<int> value;
+            way() : used(false), key(0), version(0), hits(0), stamp(0) {}
+        };
+
+        lru &shared;
+        std::mutex &lock;
+        std::uint32_t refresh;
+        std::uint64_t clock;
+        way ways[Sets][Ways];
+
+    public:
+        /**
+         * every access to shared must hold lock
+         */
+        front_cache(lru &shared, std::mutex &lock, std::uint32_t refresh = 256)
+            : shared(shared), lock(lock), refresh(refresh), clock(0) {}
+        front_cache(const front_cache &other) = delete;
+        front_cache &operator=(const front_cache &other) = delete;
+
+        /**
+         * return the value connected with key, valid until the next call.
+         * if the key not found, throw
+         */
+        const Matrix<int> *get(int key) {
+            way *set = ways[Hash()(key) & (Sets - 1)];
+            way *victim = nullptr;
+            for (size_t i = 0; i < Ways; i++) {
+                way &w = set[i];
+                if (w.used && w.key == key) {
+                    if (shared.version(key) == w.version && ++w.hits < refresh) {
+                        w.stamp = ++clock;
+                        return &w.value;
+                    }
+                    victim = &w;
+                    break;
+                }
+                if (!victim || (victim->used && (!w.used || w.stamp < victim->stamp))) victim = &w;
+            }
+            std::lock_guard<std::mutex> guard(lock);
+            victim->used = false;
+            victim->version = shared.version(key);
+            victim->value = shared.lookup(key);
+            victim->key = key;
+            victim->hits = 0;
+            victim->stamp = ++clock;
+            victim->used = true;
+            return &victim->value;
+        }
+        const Matrix<int> *get(const Integer &key) {
+            return get(key.val);
+        }
+
+        /**
+         * drop every entry (and the handles they hold)
+         */
+        void clear() {
+            for (size_t s = 0; s < Sets; s++) {
+                for (size_t i = 0; i < Ways; i++) {
+                    ways[s][i].used = false;
+                    ways[s][i].value = Matrix<int>();
+                }
+            }
+        }
+    };
+}
+
+#endif
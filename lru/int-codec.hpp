@@ -0,0 +1,169 @@
+#ifndef SJTU_INT_CODEC_HPP
+#define SJTU_INT_CODEC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__GNUC__) && defined(__SSE2__)
+#define SJTU_INT_CODEC_SSE2 1
+#include <emmintrin.h>
+#endif
+
+/**
+ * A fast codec for int32 buffers with small dynamic range.
+ * Values are cut into blocks of kBlock. Each block stores its first
+ * value, then the zigzagged deltas between neighbours bit-packed with
+ * the width of the largest one, so a constant block takes two words.
+ * The packed words are laid out in four interleaved lanes (value i goes
+ * to lane i % 4), so the decoder unpacks four values per SSE2 shift.
+ * Encoded layout (uint32 words):
+ *   n, then per block: first, width, width * 4 packed words
+ */
+namespace int_codec {
+
+const size_t kBlock = 128;
+const size_t kLanes = 4;
+
+inline std::uint32_t ZigZag(std::uint32_t delta)
+{
+    return (delta << 1) ^ (0u - (delta >> 31));
+}
+
+inline std::uint32_t UnZigZag(std::uint32_t zz)
+{
+    return (zz >> 1) ^ (0u - (zz & 1));
+}
+
+inline std::uint32_t BitWidth(std::uint32_t x)
+{
+    std::uint32_t width = 0;
+    while (x) {
+        ++width;
+        x >>= 1;
+    }
+    return width;
+}
+
+/**
+ * Append the encoding of src[0, n) to out.
+ */
+inline void Encode(const int *src, size_t n, std::vector<std::uint32_t> &out)
+{
+    out.push_back(static_cast<std::uint32_t>(n));
+    std::uint32_t zz[kBlock];
+    for (size_t b0 = 0; b0 < n; b0 += kBlock) {
+        size_t len = n - b0 < kBlock ? n - b0 : kBlock;
+        const std::uint32_t *v = reinterpret_cast<const std::uint32_t *>(src + b0);
+        std::uint32_t all = 0;
+        zz[0] = 0;
+        for (size_t i = 1; i < kBlock; ++i) {
+            zz[i] = i < len ? ZigZag(v[i] - v[i - 1]) : 0;
+            all |= zz[i];
+        }
+        std::uint32_t width = BitWidth(all);
+        out.push_back(v[0]);
+        out.push_back(width);
+        size_t base = out.size();
+        out.resize(base + width * kLanes, 0);
+        for (size_t i = 0; width && i < kBlock; ++i) {
+            size_t lane = i % kLanes, bit = (i / kLanes) * width;
+            std::uint32_t *word = &out[base + (bit / 32) * kLanes + lane];
+            word[0] |= zz[i] << (bit % 32);
+            if (bit % 32 + width > 32) word[kLanes] |= zz[i] >> (32 - bit % 32);
+        }
+    }
+}
+
+/**
+ * Unpack the kBlock zigzagged deltas of one block into zz.
+ */
+inline void Unpack(const std::uint32_t *in, std::uint32_t width, std::uint32_t *zz)
+{
+    const size_t kPerLane = kBlock / kLanes;
+    if (width == 0) {
+        for (size_t i = 0; i < kBlock; ++i) zz[i] = 0;
+        return;
+    }
+#ifdef SJTU_INT_CODEC_SSE2
+    const __m128i *p = reinterpret_cast<const __m128i *>(in);
+    const __m128i mask = _mm_set1_epi32(width == 32 ? -1 : static_cast<int>((1u << width) - 1));
+    __m128i cur = _mm_loadu_si128(p++);
+    std::uint32_t shift = 0;
+    for (size_t k = 0; k < kPerLane; ++k) {
+        __m128i v = _mm_srl_epi32(cur, _mm_cvtsi32_si128(shift));
+        shift += width;
+        if (shift >= 32) {
+            shift -= 32;
+            if (k + 1 < kPerLane) cur = _mm_loadu_si128(p++);
+            if (shift) v = _mm_or_si128(v, _mm_sll_epi32(cur, _mm_cvtsi32_si128(width - shift)));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(zz + k * kLanes), _mm_and_si128(v, mask));
+    }
+#else
+    const std::uint32_t mask = width == 32 ? ~0u : (1u << width) - 1;
+    for (size_t i = 0; i < kBlock; ++i) {
+        size_t lane = i % kLanes, bit = (i / kLanes) * width;
+        const std::uint32_t *word = in + (bit / 32) * kLanes + lane;
+        std::uint32_t x = word[0] >> (bit % 32);
+        if (bit % 32 + width > 32) x |= word[kLanes] << (32 - bit % 32);
+        zz[i] = x & mask;
+    }
+#endif
+}
+
+/**
+ * Undo the zigzag and the deltas of one block in place,
+ * starting from first.
+ */
+inline void PrefixSum(std::uint32_t *zz, std::uint32_t first)
+{
+#ifdef SJTU_INT_CODEC_SSE2
+    __m128i carry = _mm_set1_epi32(static_cast<int>(first));
+    const __m128i one = _mm_set1_epi32(1);
+    for (size_t i = 0; i < kBlock; i += kLanes) {
+        __m128i z = _mm_loadu_si128(reinterpret_cast<const __m128i *>(zz + i));
+        __m128i d = _mm_xor_si128(_mm_srli_epi32(z, 1), _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(z, one)));
+        d = _mm_add_epi32(d, _mm_slli_si128(d, 4));
+        d = _mm_add_epi32(d, _mm_slli_si128(d, 8));
+        d = _mm_add_epi32(d, carry);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(zz + i), d);
+        carry = _mm_shuffle_epi32(d, 0xff);
+    }
+#else
+    std::uint32_t acc = first;
+    for (size_t i = 0; i < kBlock; ++i) {
+        acc += UnZigZag(zz[i]);
+        zz[i] = acc;
+    }
+#endif
+}
+
+/**
+ * The number of values encoded at in.
+ */
+inline size_t Count(const std::uint32_t *in)
+{
+    return in[0];
+}
+
+/**
+ * Decode the buffer written by Encode() into dst[0, Count(in)).
+ */
+inline void Decode(const std::uint32_t *in, int *dst)
+{
+    size_t n = *in++;
+    std::uint32_t block[kBlock];
+    for (size_t b0 = 0; b0 < n; b0 += kBlock) {
+        std::uint32_t first = in[0], width = in[1];
+        Unpack(in + 2, width, block);
+        PrefixSum(block, first);
+        in += 2 + width * kLanes;
+        size_t len = n - b0 < kBlock ? n - b0 : kBlock;
+        for (size_t i = 0; i < len; ++i) dst[b0 + i] = static_cast<int>(block[i]);
+    }
+}
+
+}
+
+#endif
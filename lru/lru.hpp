@@ -1,25 +1,79 @@
 #ifndef SJTU_LRU_HPP
 #define SJTU_LRU_HPP
 
+#include "bloom-filter.hpp"
 #include "class-integer.hpp"
 #include "class-matrix.hpp"
 #include "exceptions.hpp"
+#include "int-codec.hpp"
 #include "utility.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <type_traits>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#if defined(__GNUC__)
+#define SJTU_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define SJTU_PREFETCH(p) ((void)0)
+#endif
+
+/**
+ * both are transparent: an int can be looked up
+ * without building a temporary Integer
+ */
 class Hash {
 public:
-    unsigned int operator()(Integer lhs) const {
-        int val = lhs.val;
+    using is_transparent = void;
+    unsigned int operator()(const Integer &lhs) const {
+        return (*this)(lhs.val);
+    }
+    unsigned int operator()(int val) const {
         return std::hash<int>()(val);
     }
 };
 class Equal {
 public:
+    using is_transparent = void;
     bool operator()(const Integer &lhs, const Integer &rhs) const {
         return lhs.val == rhs.val;
     }
+    bool operator()(const Integer &lhs, int rhs) const {
+        return lhs.val == rhs;
+    }
+    bool operator()(int lhs, const Integer &rhs) const {
+        return lhs == rhs.val;
+    }
 };
 
 namespace sjtu {
+    template <class...>
+    struct make_void {
+        typedef void type;
+    };
+    /**
+     * whether Hash and Equal both declare is_transparent,
+     * i.e. accept other key-like types in place of the key
+     */
+    template <class Hash, class Equal, class = void>
+    struct is_transparent : std::false_type {};
+    template <class Hash, class Equal>
+    struct is_transparent<Hash, Equal,
+        typename make_void<typename Hash::is_transparent, typename Equal::is_transparent>::type> : std::true_type {};
+    /**
+     * enables the heterogeneous overload of a lookup taking K
+     */
+    template <class K, class Key, class Hash, class Equal>
+    using enable_if_transparent =
+        typename std::enable_if<!std::is_same<K, Key>::value && is_transparent<Hash, Equal>::value, int>::type;
+
     template <class T>
     class double_list {
     public:
@@ -30,6 +84,7 @@ namespace sjtu {
             Node *dual;     // Thanks Teacher_BigN
             Node() : data(nullptr), prev(nullptr), next(nullptr), dual(nullptr) {}
             Node(const T &val) : data(new T(val)), prev(nullptr), next(nullptr), dual(nullptr) {}
+            Node(T &&val) : data(new T(std::move(val))), prev(nullptr), next(nullptr), dual(nullptr) {}
 
             void bind(Node *d) {
                 if (d->dual) {
@@ -66,19 +121,35 @@ namespace sjtu {
         double_list(const double_list<T> &other) {
             head = new Node();
             head->next = head->prev = head;
-            for (auto it = other.begin(); it != other.end(); it++) {
-                insert_tail(*it);
-            }
+            other.for_each([this](const T &val) { insert_tail(val); });
+        }
+
+        /**
+         * steal the nodes, other is left with a fresh head
+         * and is an empty list afterwards. allocating that head
+         * may throw, so unlike the move assignment this isn't noexcept
+         */
+        double_list(double_list<T> &&other) : double_list() {
+            swap(other);
         }
 
         double_list<T> &operator=(const double_list<T> &other) {
+            if (this == &other) return *this;
             clear();
-            for (auto it = other.begin(); it != other.end(); it++) {
-                insert_tail(*it);
-            }
+            other.for_each([this](const T &val) { insert_tail(val); });
+            return *this;
+        }
+        double_list<T> &operator=(double_list<T> &&other) noexcept {
+            swap(other);
             return *this;
         }
 
+        void swap(double_list<T> &other) noexcept {
+            Node *tmp = head;
+            head = other.head;
+            other.head = tmp;
+        }
+
         ~double_list() {
             clear();
             delete head;
@@ -103,6 +174,7 @@ namespace sjtu {
             iterator() : ptr(nullptr) {}
             iterator(Node *ptr) : ptr(ptr) {}
             iterator(const iterator &t) : ptr(t.ptr) {}
+            iterator &operator=(const iterator &t) = default;
             ~iterator() {}
             /**
              * iter++
@@ -230,6 +302,34 @@ namespace sjtu {
             pos.ptr->next->prev = pos.ptr->prev->next = pos.ptr;
         }
 
+        /**
+         * unlink the first node without destroying it,
+         * return nullptr if the list is empty
+         */
+        Node *unlink_head() {
+            if (empty()) return nullptr;
+            Node *obj = head->next;
+            obj->prev->next = obj->next;
+            obj->next->prev = obj->prev;
+            obj->next = obj->prev = nullptr;
+            return obj;
+        }
+
+        /**
+         * link an existing node, the list takes the ownership
+         */
+        void link_head(Node *obj) {
+            obj->next = head->next;
+            obj->prev = head;
+            obj->next->prev = obj->prev->next = obj;
+        }
+
+        void link_tail(Node *obj) {
+            obj->next = head;
+            obj->prev = head->prev;
+            obj->next->prev = obj->prev->next = obj;
+        }
+
         /**
          * the following are operations of double list
          */
@@ -238,7 +338,11 @@ namespace sjtu {
             obj->next = head->next;
             obj->prev = head;
             obj->next->prev = obj->prev->next = obj;
-        } void insert_tail(const T &val) {
+        }
+        void insert_head(T &&val) {
+            link_head(new Node(std::move(val)));
+        }
+        void insert_tail(const T &val) {
             Node *obj = new Node(val);
             obj->next = head;
             obj->prev = head->prev;
@@ -274,6 +378,52 @@ namespace sjtu {
         bool empty() const {
             return head->next == head;
         }
+
+        /**
+         * call fn(value) from head to tail, without the checks of
+         * iterator, the next node is prefetched while fn runs.
+         * fn may remove the current node, but nothing else.
+         */
+        template <class Fn>
+        void for_each(Fn &&fn) const {
+            for (Node *obj = head->next, *next; obj != head; obj = next) {
+                next = obj->next;
+                SJTU_PREFETCH(next);
+                fn(*obj->data);
+            }
+        }
+
+        /**
+         * call fn(values, n) with up to batch (at most 64) values at a time,
+         * the values of a batch are prefetched while it is gathered.
+         * fn must not insert or remove.
+         */
+        template <class Fn>
+        void for_each_batch(Fn &&fn, size_t batch = 16) const {
+            T *values[64];
+            if (batch == 0 || batch > 64) batch = 64;
+            size_t n = 0;
+            for (Node *obj = head->next; obj != head; obj = obj->next) {
+                SJTU_PREFETCH(obj->data);
+                values[n++] = obj->data;
+                if (n == batch) {
+                    fn(values, n);
+                    n = 0;
+                }
+            }
+            if (n) fn(values, n);
+        }
+
+        /**
+         * the first node whose value satisfies pred, nullptr if none
+         */
+        template <class Pred>
+        Node *find_node(Pred &&pred) const {
+            for (Node *obj = head->next; obj != head; obj = obj->next) {
+                if (pred(*obj->data)) return obj;
+            }
+            return nullptr;
+        }
     };
 
     template <
@@ -288,16 +438,27 @@ namespace sjtu {
 
         int capacity, size;
         double load_factor;
+        double shrink_threshold = 0;
         List* data;
 
-        int pos(const Key &key) const {
+        static const int min_capacity = 10;
+        static constexpr double max_shrink_threshold = 0.25;
+
+        template <class K>
+        int pos(const K &key) const {
             return Hash()(key) % capacity;
         }
 
-        bool eq(const Key &key1, const Key &key2) const {
+        template <class K>
+        bool eq(const Key &key1, const K &key2) const {
             return Equal()(key1, key2);
         }
 
+        template <class K>
+        typename List::Node *find_node(const K &key) const {
+            return data[pos(key)].find_node([&](const value_type &v) { return eq(v.first, key); });
+        }
+
     public:
         /**
          * elements
@@ -313,18 +474,40 @@ namespace sjtu {
         hashmap(int capacity = 10, double load_factor = 0.75) : capacity(capacity), load_factor(load_factor), size(0) {
             data = new List[capacity];
         }
-        hashmap(const hashmap &other) : capacity(other.capacity), load_factor(other.load_factor), size(other.size) {
+        hashmap(const hashmap &other)
+            : capacity(other.capacity), size(other.size), load_factor(other.load_factor),
+              shrink_threshold(other.shrink_threshold) {
             data = new List[capacity];
             for (int i=0; i<capacity; i++) {
                 data[i] = other.data[i];
             }
         }
+        /**
+         * steal the buckets, other is left with min_capacity
+         * fresh ones and is an empty map afterwards, which may throw
+         */
+        hashmap(hashmap &&other) : hashmap(min_capacity) {
+            swap(other);
+        }
         ~hashmap() {
             delete[] data;
         }
+        hashmap &operator=(hashmap &&other) noexcept {
+            swap(other);
+            return *this;
+        }
+        void swap(hashmap &other) noexcept {
+            std::swap(capacity, other.capacity);
+            std::swap(size, other.size);
+            std::swap(load_factor, other.load_factor);
+            std::swap(shrink_threshold, other.shrink_threshold);
+            std::swap(data, other.data);
+        }
         hashmap &operator=(const hashmap &other) {
+            if (this == &other) return *this;
             capacity = other.capacity;
             load_factor = other.load_factor;
+            shrink_threshold = other.shrink_threshold;
             size = other.size;
             delete[] data;
             data = new List[capacity];
@@ -355,6 +538,7 @@ namespace sjtu {
             }
             iterator(const iterator &t) : ptr(t.ptr) {
             }
+            iterator &operator=(const iterator &t) = default;
             ~iterator() {}
 
             /**
@@ -383,18 +567,131 @@ namespace sjtu {
             for (int i = 0; i < capacity; i++) {
                 data[i].clear();
             }
+            size = 0;
+            auto_shrink();
         }
+
+        /**
+         * rebuild the buckets with new_capacity heads,
+         * nodes are relinked instead of copied,
+         * so iterators (and the dual of each node) stay valid
+         */
+        void rehash(int new_capacity) {
+            List *old = data;
+            int old_capacity = capacity;
+            data = new List[new_capacity];
+            capacity = new_capacity;
+            for (int i = 0; i < old_capacity; i++) {
+                while (typename List::Node *obj = old[i].unlink_head()) {
+                    data[pos(obj->data->first)].link_head(obj);
+                }
+            }
+            delete[] old;
+        }
+
+        /**
+         * make room for n elements, so that the next
+         * n - size insertions never expand()
+         */
+        void reserve(int n) {
+            int need = static_cast<int>(n / load_factor) + 1;
+            if (need > capacity) rehash(need);
+        }
+
+        /**
+         * rehash into the fewest buckets that hold size elements
+         * and hand the freed heap back to the OS
+         */
+        void shrink_to_fit() {
+            int need = static_cast<int>(size / load_factor) + 1;
+            if (need < min_capacity) need = min_capacity;
+            if (need < capacity) rehash(need);
+            release_memory();
+        }
+
+        /**
+         * shrink automatically once fewer than threshold * capacity * load_factor
+         * elements are left (0, the default, never shrinks).
+         * the table is left half full, so the next insertions don't expand.
+         * a threshold above max_shrink_threshold is taken as it, so half of
+         * the elements must go again before the next shrink.
+         * this only rehashes, it runs from clear() and remove() so trimming
+         * the heap is left to an explicit shrink_to_fit()
+         */
+        void set_shrink_threshold(double threshold) {
+            shrink_threshold = threshold < max_shrink_threshold ? threshold : max_shrink_threshold;
+            auto_shrink();
+        }
+
+        void auto_shrink() {
+            if (shrink_threshold <= 0 || capacity <= min_capacity
+                || size >= capacity * load_factor * shrink_threshold) return;
+            int need = static_cast<int>(2 * size / load_factor) + 1;
+            if (need < min_capacity) need = min_capacity;
+            if (need < capacity) rehash(need);
+        }
+
+        /**
+         * the buckets and nodes come from malloc, so giving the
+         * free pages at the top of the heap back is all there is to do
+         */
+        static void release_memory() {
+#if defined(__GLIBC__)
+            malloc_trim(0);
+#endif
+        }
+
         /**
          * you need to expand the hashmap dynamically
+         * the nodes are relinked into twice as many buckets,
+         * nothing is copied
          */
         virtual void expand() {
-            hashmap tmp(capacity * 2, load_factor);
-            for (int i = 0; i < capacity; i++) {
-                for (auto it = data[i].begin(); it!= data[i].end(); it++) {
-                    tmp.insert(*it);
-                }
+            rehash(capacity * 2);
+        }
+
+        /**
+         * fill the map, which must be empty, with [first, last),
+         * whose keys must be distinct. the elements are bucket-sorted
+         * by hash first, so every bucket is written in one go, and no
+         * lookup or expand() happens.
+         * return the new node of every element, in input order
+         */
+        template <class ForwardIt>
+        std::vector<typename List::Node *> build_buckets(ForwardIt first, ForwardIt last) {
+            std::vector<ForwardIt> values;
+            for (; first != last; ++first) values.push_back(first);
+            size_t n = values.size();
+            reserve(static_cast<int>(n));
+            std::vector<int> index(n);
+            std::vector<size_t> start(capacity + 1, 0), order(n);
+            for (size_t i = 0; i < n; i++) {
+                index[i] = pos((*values[i]).first);
+                start[index[i] + 1]++;
             }
-            *this = tmp;
+            for (int b = 0; b < capacity; b++) start[b + 1] += start[b];
+            for (size_t i = 0; i < n; i++) order[start[index[i]]++] = i;
+            std::vector<typename List::Node *> nodes(n);
+            for (size_t i : order) {
+                nodes[i] = new typename List::Node(value_type(*values[i]));
+                data[index[i]].link_head(nodes[i]);
+            }
+            size += static_cast<int>(n);
+            return nodes;
+        }
+
+        /**
+         * replace everything with [first, last) (or range),
+         * the keys must be distinct
+         */
+        template <class ForwardIt>
+        void build_from(ForwardIt first, ForwardIt last) {
+            clear();
+            build_buckets(first, last);
+        }
+        template <class Range>
+        void build_from(const Range &range) {
+            build_from(range.begin(), range.end());
         }
 
         /**
@@ -403,18 +700,60 @@ namespace sjtu {
         iterator end() const {
             return iterator();
         }
+
+        /**
+         * call fn(value_pair) for every element, bucket by bucket,
+         * no iterator checks. fn must not insert or remove.
+         */
+        template <class Fn>
+        void for_each(Fn fn) {
+            for (int i = 0; i < capacity; i++) {
+                data[i].for_each(fn);
+            }
+        }
+        template <class Fn>
+        void for_each(Fn fn) const {
+            for (int i = 0; i < capacity; i++) {
+                data[i].for_each([&fn](const value_type &value) { fn(value); });
+            }
+        }
+
+        /**
+         * call fn(value_pairs, n) with up to batch (at most 64) elements
+         * at a time in bucket order, each batch prefetched as it is gathered
+         */
+        template <class Fn>
+        void for_each_batch(Fn fn, size_t batch = 16) const {
+            value_type *values[64];
+            if (batch == 0 || batch > 64) batch = 64;
+            size_t n = 0;
+            for (int i = 0; i < capacity; i++) {
+                for (auto *obj = data[i].head->next; obj != data[i].head; obj = obj->next) {
+                    SJTU_PREFETCH(obj->data);
+                    values[n++] = obj->data;
+                    if (n == batch) {
+                        fn(values, n);
+                        n = 0;
+                    }
+                }
+            }
+            if (n) fn(values, n);
+        }
         /**
          * find, return a pointer point to the value
          * not find, return the end (point to nothing)
          */
         iterator find(const Key &key) const {
-            int index = pos(key);
-            for (auto it = data[index].begin(); it!= data[index].end(); it++) {
-                if (eq(it->first, key)) {
-                    return iterator(it);
-                }
-            }
-            return end();
+            auto *obj = find_node(key);
+            return obj ? iterator(typename List::iterator(obj)) : end();
+        }
+        /**
+         * the same with any key-like K, if Hash and Equal are transparent
+         */
+        template <class K, enable_if_transparent<K, Key, Hash, Equal> = 0>
+        iterator find(const K &key) const {
+            auto *obj = find_node(key);
+            return obj ? iterator(typename List::iterator(obj)) : end();
         }
         /**
          * already have a value_pair with the same key
@@ -425,17 +764,28 @@ namespace sjtu {
         sjtu::pair<iterator, bool> insert(const value_type &value_pair) {
             if (size >= capacity * load_factor) expand();
             int index = pos(value_pair.first);
-            for (auto it = data[index].begin(); it!= data[index].end(); it++) {
-                if (eq(it->first, value_pair.first)) {
-                    it->second = value_pair.second;
-                    return sjtu::pair<iterator, bool>(iterator(it), false);
-                }
+            auto *obj = data[index].find_node([&](const value_type &v) { return eq(v.first, value_pair.first); });
+            if (obj) {
+                obj->data->second = value_pair.second;
+                return sjtu::pair<iterator, bool>(iterator(typename List::iterator(obj)), false);
             }
             data[index].insert_head(value_pair);
             size++;
             return sjtu::pair<iterator, bool>(iterator(data[index].begin()), true);
         }
 
+        /**
+         * insert a value_pair whose key is known to be absent,
+         * without looking up the bucket and without expanding,
+         * reserve() first
+         */
+        iterator insert_unique(value_type &&value_pair) {
+            int index = pos(value_pair.first);
+            data[index].insert_head(std::move(value_pair));
+            size++;
+            return iterator(data[index].begin());
+        }
+
         /**
          * the value_pair exists, remove and return true
          * otherwise, return false
@@ -445,6 +795,7 @@ namespace sjtu {
             if (it==end()) return false;
             data[pos(key)].erase(it.ptr);
             size--;
+            auto_shrink();
             return true;
         }
     };
@@ -485,6 +836,7 @@ namespace sjtu {
             }
             iterator(const iterator &other) : ptr(other.ptr) {
             }
+            iterator &operator=(const iterator &other) = default;
             ~iterator() {
             }
 
@@ -624,25 +976,90 @@ namespace sjtu {
 
         linked_hashmap() : super() {
         }
-        linked_hashmap(const linked_hashmap &other) : super(other), link(other.link){
-            redual();
+        /**
+         * start with capacity buckets instead of the default
+         */
+        explicit linked_hashmap(int capacity, double load_factor = 0.75) : super(capacity, load_factor) {
+        }
+        /**
+         * one pass over other.link: every value is copied once, hashed once
+         * into a bucket of the same capacity and bound to its new link node,
+         * no redual()
+         */
+        linked_hashmap(const linked_hashmap &other) : super(other.capacity, other.load_factor) {
+            super::shrink_threshold = other.shrink_threshold;
+            for (auto *node = other.link.head->next; node != other.link.head; node = node->next) {
+                typename List::Node *bucket = new typename List::Node(*node->data);
+                super::data[super::pos(bucket->data->first)].link_head(bucket);
+                typename List::Node *obj = new typename List::Node();
+                link.link_tail(obj);
+                obj->bind(bucket);
+                super::size++;
+            }
+        }
+        /**
+         * the nodes move with their lists, so every dual stays bound,
+         * other is left an empty map (with fresh buckets and head,
+         * which may throw)
+         */
+        linked_hashmap(linked_hashmap &&other) : super(std::move(other)), link(std::move(other.link)) {
         }
         ~linked_hashmap() {
         }
         linked_hashmap &operator=(const linked_hashmap &other) {
-            super::operator=(other);
-            link = other.link;
-            redual();
+            if (this == &other) return *this;
+            linked_hashmap tmp(other);
+            swap(tmp);
+            return *this;
+        }
+        linked_hashmap &operator=(linked_hashmap &&other) noexcept {
+            swap(other);
             return *this;
         }
+        void swap(linked_hashmap &other) noexcept {
+            super::swap(other);
+            link.swap(other.link);
+        }
 
         void redual() {
-            for (auto it=link.begin(); it!=link.end(); it++) {
-                auto hashit = super::find(it->first);
-                it.bind(hashit.ptr);
+            for (auto *obj = link.head->next; obj != link.head; obj = obj->next) {
+                obj->bind(super::find(obj->data->first).ptr.ptr);
             }
         }
 
+        /**
+         * call fn(value_pair) for every element in insertion order
+         * (oldest first), no iterator checks.
+         * fn must not insert or remove.
+         */
+        template <class Fn>
+        void for_each(Fn fn) {
+            link.for_each(fn);
+        }
+        template <class Fn>
+        void for_each(Fn fn) const {
+            link.for_each([&fn](const value_type &value) { fn(value); });
+        }
+        /**
+         * call fn(value_pairs, n) in insertion order,
+         * up to batch (at most 64) prefetched elements at a time
+         */
+        template <class Fn>
+        void for_each_batch(Fn fn, size_t batch = 16) const {
+            link.for_each_batch(fn, batch);
+        }
+        /**
+         * the same in bucket order
+         */
+        template <class Fn>
+        void for_each_bucket(Fn fn) {
+            super::for_each(fn);
+        }
+        template <class Fn>
+        void for_each_bucket(Fn fn) const {
+            super::for_each(fn);
+        }
+
         /**
          * return the value connected with the Key(O(1))
          * if the key not found, throw
@@ -661,6 +1078,25 @@ namespace sjtu {
             }
             return it->second;
         }
+        /**
+         * the same with any key-like K, if Hash and Equal are transparent
+         */
+        template <class K, enable_if_transparent<K, Key, Hash, Equal> = 0>
+        T &at(const K &key) {
+            auto *obj = super::find_node(key);
+            if (!obj) {
+                throw index_out_of_bound();
+            }
+            return obj->data->second;
+        }
+        template <class K, enable_if_transparent<K, Key, Hash, Equal> = 0>
+        const T &at(const K &key) const {
+            auto *obj = super::find_node(key);
+            if (!obj) {
+                throw index_out_of_bound();
+            }
+            return obj->data->second;
+        }
         T &operator[](const Key &key) {
             return at(key);
         }
@@ -704,11 +1140,6 @@ namespace sjtu {
             return super::size;
         }
 
-        virtual void expand() override{
-            super::expand();
-            redual();
-        }
-
         /**
          * insert the value_piar
          * if the key of the value_pair exists in the map
@@ -722,10 +1153,10 @@ namespace sjtu {
         pair<iterator, bool> insert(const value_type &value) {
             auto result = super::insert(value);
             if (result.second) {
-                link.insert_tail(value);
-                auto it = --link.end();
-                it.bind(result.first.ptr);
-                return pair<iterator, bool>(iterator(it), true);
+                typename List::Node *obj = new typename List::Node();
+                link.link_tail(obj);
+                obj->bind(result.first.ptr.ptr);
+                return pair<iterator, bool>(iterator(typename List::iterator(obj)), true);
             } else {
                 typename List::iterator dual = result.first.ptr.dual();
                 link.move_tail(dual);
@@ -733,6 +1164,46 @@ namespace sjtu {
             }
         }
 
+        /**
+         * append a value_pair whose key is known to be absent
+         * as the newest element, no lookup, no expand() and
+         * no redual(), the link node shares the bucket node's data
+         */
+        iterator insert_unique(value_type &&value) {
+            auto bucket = super::insert_unique(std::move(value));
+            typename List::Node *obj = new typename List::Node();
+            link.link_tail(obj);
+            obj->bind(bucket.ptr.ptr);
+            return iterator(typename List::iterator(obj));
+        }
+
+        /**
+         * replace everything with [first, last) (or range), the keys
+         * must be distinct. the buckets are built by super::build_buckets(),
+         * then the elements are linked in input order, no redual()
+         */
+        template <class ForwardIt>
+        void build_from(ForwardIt first, ForwardIt last) {
+            clear();
+            for (auto *bucket : super::build_buckets(first, last)) {
+                typename List::Node *obj = new typename List::Node();
+                link.link_tail(obj);
+                obj->bind(bucket);
+            }
+        }
+        template <class Range>
+        void build_from(const Range &range) {
+            build_from(range.begin(), range.end());
+        }
+
+        /**
+         * move the value_pair pointed by the iterator to the
+         * end of the list (the newest one), the value is untouched
+         */
+        void touch(iterator pos) {
+            link.move_tail(pos.ptr);
+        }
+
         /**
          * erase the value_pair pointed by the iterator
          * if the iterator points to nothing
@@ -749,6 +1220,10 @@ namespace sjtu {
         size_t count(const Key &key) const {
             return super::find(key)!=super::end();
         }
+        template <class K, enable_if_transparent<K, Key, Hash, Equal> = 0>
+        size_t count(const K &key) const {
+            return super::find_node(key) != nullptr;
+        }
         /**
          * find the iterator points at the value_pair
          * which consist of key
@@ -760,36 +1235,635 @@ namespace sjtu {
             if (it==super::end()) return end();
             else return iterator(it.ptr.dual());
         }
+        template <class K, enable_if_transparent<K, Key, Hash, Equal> = 0>
+        iterator find(const K &key) {
+            auto *obj = super::find_node(key);
+            return obj ? iterator(typename List::iterator(obj->dual)) : end();
+        }
+    };
+
+    /**
+     * a slower place evicted values go to, and come back from on a miss
+     */
+    class second_tier {
+    public:
+        virtual ~second_tier() {}
+        virtual void put(const Integer &key, const Matrix<int> &value) = 0;
+        /**
+         * move the value of key out of the tier, return false if absent
+         */
+        virtual bool take(const Integer &key, Matrix<int> &value) = 0;
+        virtual void erase(const Integer &key) = 0;
+        /**
+         * forget every value, called when the lru is cleared or reloaded
+         */
+        virtual void clear() = 0;
+    };
+
+    /**
+     * why a value_pair left an lru
+     */
+    enum class eviction_cause {
+        size,       // pushed out by a newer one
+        expiry,     // its time to live ran out
+        removed,    // lru::remove()
+        replaced    // save() with the same key
+    };
+
+    /**
+     * the key is kept as a plain int, so that a batch can be handed
+     * to another thread without touching Integer::counter there
+     */
+    struct eviction {
+        int key;
+        Matrix<int> value;
+        eviction_cause cause;
+        eviction(int key, Matrix<int> &&value, eviction_cause cause)
+            : key(key), value(std::move(value)), cause(cause) {}
+    };
+
+    /**
+     * receives the value_pairs leaving an lru, a batch at a time,
+     * on the thread that made them leave
+     */
+    class eviction_listener {
+    public:
+        virtual ~eviction_listener() {}
+        /**
+         * the evictions may be moved from
+         */
+        virtual void on_evict(eviction *batch, size_t n) = 0;
+    };
+
+    /**
+     * destroys the values an lru no longer needs somewhere else
+     */
+    class value_reclaimer {
+    public:
+        virtual ~value_reclaimer() {}
+        /**
+         * take over every value in values, leaving it empty
+         */
+        virtual void retire(std::vector<Matrix<int> > &values) = 0;
     };
 
     class lru {
         using lmap = sjtu::linked_hashmap<Integer, Matrix<int>, Hash, Equal>;
         using value_type = sjtu::pair<const Integer, Matrix<int> >;
 
+        static const int snapshot_magic_size = 8;
+        static const char *snapshot_magic() {
+            return "SJTULRU1";
+        }
+
+        /**
+         * every key hashes to one of n_versions stripes, and a stripe is
+         * bumped whenever a value in it may change: save(), get() (which
+         * hands out a writable pointer), eviction and load_snapshot()
+         */
+        static const int n_versions = 256;
+        std::atomic<std::uint32_t> versions[n_versions];
+
+        template <class K>
+        void bump(const K &key) {
+            versions[Hash()(key) % n_versions].fetch_add(1, std::memory_order_release);
+        }
+        void bump_all() {
+            for (int i = 0; i < n_versions; i++) versions[i].fetch_add(1, std::memory_order_release);
+        }
+
+        template <class K>
+        Matrix<int> *touch_as(const K &v) {
+            if (surely_absent(v)) {
+                throw index_out_of_bound();
+            }
+            auto it = map.find(v);
+            if (it == map.end()) {
+                throw index_out_of_bound();
+            }
+            warm(it);
+            map.touch(it);
+            return &it->second;
+        }
+        template <class K>
+        Matrix<int> *get_as(const K &v) {
+            Matrix<int> *value = touch_as(v);
+            bump(v);
+            return value;
+        }
+
+        second_tier *tier;
+        eviction_listener *listener;
+        size_t batch;
+        std::vector<eviction> pending;
+
+        /**
+         * hand the value of it (moved out) to the listener
+         */
+        void evict(lmap::iterator it, eviction_cause cause) {
+            pending.emplace_back(it->first.val, std::move(it->second), cause);
+            if (pending.size() >= batch) flush_evictions();
+        }
+
+        /**
+         * values waiting to be destroyed off the hot path
+         */
+        bool deferred;
+        value_reclaimer *reclaimer;
+        std::vector<Matrix<int> > graveyard;
+
+        static const size_t reclaim_batch = 64;
+
+        /**
+         * move the value of it to the listener or to the graveyard,
+         * so that destroying its node frees nothing big
+         */
+        void release(lmap::iterator it, eviction_cause cause) {
+            if (listener) {
+                evict(it, cause);
+            } else if (deferred) {
+                graveyard.push_back(std::move(it->second));
+                if (reclaimer && graveyard.size() >= reclaim_batch) reclaimer->retire(graveyard);
+            }
+        }
+        /**
+         * release every value_pair of m as removed (a cold one is decoded
+         * for the listener first), before the nodes of m are freed
+         */
+        void release_all(lmap &m) {
+            if (!listener && !deferred) return;
+            for (auto it = m.begin(); it != m.end(); ++it) {
+                if (compress && listener) it->second = decoded(*it);
+                release(it, eviction_cause::removed);
+            }
+        }
+
+        /**
+         * a cold value encoded by int_codec, its entry in map holds an
+         * empty Matrix meanwhile. a value that would not shrink is
+         * passed over: it stays as it is and has no frozen_value
+         */
+        struct frozen_value {
+            std::uint64_t rows;
+            std::uint64_t cols;
+            std::vector<std::uint32_t> words;
+        };
+        typedef hashmap<Integer, frozen_value, Hash, Equal> frozen_map;
+        /**
+         * what a frozen_value costs besides its words: the pair, its
+         * bucket node and a malloc header for them and for the words
+         */
+        static const size_t frozen_overhead =
+            sizeof(pair<const Integer, frozen_value>) + sizeof(frozen_map::List::Node) + 3 * 16;
+        bool compress;
+        frozen_map frozen;          // the encoded values of the cold prefix of map
+        lmap::iterator frontier;    // the oldest entry not cold
+
+        /**
+         * encode the value of it if that takes less memory, counting
+         * the frozen_value around the words (but not the buffer
+         * overhead of the Matrix, so small values are kept as they are)
+         */
+        void freeze(lmap::iterator it) {
+            const Matrix<int> &mat = it->second;
+            const size_t bytes = mat.Size() * sizeof(int);
+            if (bytes <= frozen_overhead) return;
+            frozen_value cold;
+            cold.rows = mat.RowSize();
+            cold.cols = mat.ColSize();
+            int_codec::Encode(mat.Data(), mat.Size(), cold.words);
+            if (cold.words.size() * sizeof(std::uint32_t) + frozen_overhead >= bytes) return;
+            cold.words.shrink_to_fit();
+            it->second = Matrix<int>();
+            frozen.insert(pair<const Integer, frozen_value>(it->first, std::move(cold)));
+        }
+        /**
+         * it is about to move to the newest end or to leave map,
+         * decode it (if decode) and drop it from the cold prefix
+         */
+        void warm(lmap::iterator it, bool decode = true) {
+            if (!compress) return;
+            if (it == frontier) {
+                ++frontier;
+                return;
+            }
+            auto cold = frozen.find(it->first);
+            if (cold == frozen.end()) return;
+            if (decode) {
+                Matrix<int> mat(cold->second.rows, cold->second.cols);
+                int_codec::Decode(cold->second.words.data(), mat.Data());
+                it->second = std::move(mat);
+            }
+            frozen.remove(it->first);
+        }
+        /**
+         * freeze from the frontier on until half of map is encoded.
+         * the newest entry is never frozen, save() and get_or_load()
+         * have just put it there to be used
+         */
+        void cool() {
+            if (!compress || map.empty()) return;
+            const lmap::iterator newest = --map.end();
+            while (frozen.size * 2 < static_cast<int>(map.size()) && frontier != map.end() && frontier != newest) {
+                freeze(frontier);
+                ++frontier;
+            }
+        }
+        /**
+         * the value of v, decoded if it is cold
+         */
+        Matrix<int> decoded(const value_type &v) const {
+            if (!compress || v.second.Size() != 0) return v.second;
+            auto cold = frozen.find(v.first);
+            if (cold == frozen.end()) return v.second;
+            Matrix<int> mat(cold->second.rows, cold->second.cols);
+            int_codec::Decode(cold->second.words.data(), mat.Data());
+            return mat;
+        }
+
+        /**
+         * an optional blocked Bloom filter over the keys of map, a key it
+         * rejects is not resident, so a miss costs one cache line.
+         * keys leaving map stay in it as stale bits, and it is rebuilt
+         * once capacity of them pile up
+         */
+        bool filtering;
+        blocked_bloom filter;
+        int filter_stale;
+
+        template <class K>
+        bool surely_absent(const K &key) const {
+            return filtering && !filter.may_contain(Hash()(key));
+        }
+        void rebuild_filter() {
+            filter.reset(capacity + 1);
+            for (auto it = map.begin(); it != map.end(); ++it) filter.add(Hash()(it->first));
+            filter_stale = 0;
+        }
+        void filter_dropped() {
+            if (filtering && ++filter_stale > capacity) rebuild_filter();
+        }
+
+        /**
+         * keys the loader had no value for, oldest first, with the time
+         * they expire. get_or_load() answers them without the tier or
+         * the loader until then
+         */
+        using clock = std::chrono::steady_clock;
+        linked_hashmap<Integer, clock::time_point, Hash, Equal> negative;
+        int negative_capacity;
+        clock::duration negative_ttl;
+
+        /**
+         * key is a fresh negative entry, an expired one is dropped
+         */
+        bool known_absent(const Integer &key) {
+            if (negative.empty()) return false;
+            auto it = negative.find(key);
+            if (it == negative.end()) return false;
+            if (clock::now() < it->second) return true;
+            negative.remove(it);
+            return false;
+        }
+        void forget_absent(const Integer &key) {
+            if (negative.empty()) return;
+            auto it = negative.find(key);
+            if (it != negative.end()) negative.remove(it);
+        }
+        void remember_absent(const Integer &key) {
+            if (!negative_capacity) return;
+            forget_absent(key);
+            negative.insert(pair<const Integer, clock::time_point>(key, clock::now() + negative_ttl));
+            while (static_cast<int>(negative.size()) > negative_capacity) negative.remove(negative.begin());
+        }
+
     public:
         lmap map;
         int capacity;
-        lru(int size) : capacity(size) {
+        /**
+         * the buckets are sized for size value_pairs up front,
+         * so the map never expands
+         */
+        lru(int size)
+            : tier(nullptr), listener(nullptr), batch(1), deferred(false), reclaimer(nullptr),
+              compress(false), filtering(false), filter_stale(0), negative_capacity(0),
+              negative_ttl(0), capacity(size) {
+            map.reserve(size + 1);
+            for (int i = 0; i < n_versions; i++) versions[i].store(0, std::memory_order_relaxed);
         }
         ~lru() {
+            flush_evictions();
+            reclaim();
         }
         /**
          * save the value_pair in the memory
          * delete something in the memory if necessary
          */
         void save(const value_type &v) {
-            map.insert(v);
-            if (map.size() > capacity) {
-                map.remove(map.begin());
+            if (compress || listener || deferred) {
+                auto it = map.find(v.first);
+                if (it != map.end()) {
+                    warm(it, listener != nullptr);
+                    release(it, eviction_cause::replaced);
+                }
+            }
+            if (map.insert(v).second && filtering) filter.add(Hash()(v.first));
+            forget_absent(v.first);
+            bump(v.first);
+            if (compress && frontier == map.end()) frontier = map.find(v.first);
+            if (tier) tier->erase(v.first);
+            if (map.size() > size_t(capacity)) {
+                auto oldest = map.begin();
+                bump(oldest->first);
+                warm(oldest, tier || listener);
+                if (tier) tier->put(oldest->first, oldest->second);
+                release(oldest, eviction_cause::size);
+                map.remove(oldest);
+                filter_dropped();
+            }
+            cool();
+        }
+        /**
+         * the value_pair exists, remove and return true
+         * otherwise, return false.
+         * either way a miss of key remembered by cache_misses() is
+         * forgotten, so remove() also tells that the key may exist now
+         */
+        bool remove(const Integer &key) {
+            forget_absent(key);
+            auto it = map.find(key);
+            if (it == map.end()) return false;
+            bump(key);
+            warm(it, listener != nullptr);
+            if (tier) tier->erase(key);
+            release(it, eviction_cause::removed);
+            map.remove(it);
+            filter_dropped();
+            return true;
+        }
+        /**
+         * every value_pair leaving from now on goes to l (nullptr to stop),
+         * delivered once batch of them are pending or on flush_evictions().
+         * l must outlive the lru
+         */
+        void listen(eviction_listener *l, size_t batch = 1) {
+            flush_evictions();
+            listener = l;
+            this->batch = batch ? batch : 1;
+        }
+        void flush_evictions() {
+            if (pending.empty()) return;
+            listener->on_evict(pending.data(), pending.size());
+            pending.clear();
+        }
+        /**
+         * remove everything, from the attached tier too. with a listener
+         * every value_pair leaves as removed, with deferred destruction
+         * the values are kept for reclaim() and only the small nodes
+         * are freed here
+         */
+        void clear() {
+            release_all(map);
+            map.clear();
+            if (tier) tier->clear();
+            frozen.clear();
+            frontier = map.begin();
+            negative.clear();
+            if (filtering) rebuild_filter();
+            bump_all();
+        }
+        /**
+         * stop destroying the values that leave (without a listener)
+         * inside save(), remove() and clear(): they wait for reclaim(),
+         * or go to r in batches if r is given. r must outlive the lru
+         */
+        void defer_destruction(bool on, value_reclaimer *r = nullptr) {
+            reclaim();
+            deferred = on;
+            reclaimer = r;
+        }
+        /**
+         * destroy up to budget deferred values now (e.g. when idle),
+         * or hand all of them to the reclaimer.
+         * return how many are still waiting
+         */
+        size_t reclaim(size_t budget = static_cast<size_t>(-1)) {
+            if (reclaimer) {
+                if (!graveyard.empty()) reclaimer->retire(graveyard);
+                return 0;
+            }
+            for (; budget && !graveyard.empty(); budget--) graveyard.pop_back();
+            return graveyard.size();
+        }
+        /**
+         * keep about half of the value_pairs, the oldest ones, encoded by
+         * int_codec; values that would not get smaller with their
+         * bookkeeping stay as they are. a hit decodes the value again,
+         * off decodes everything back. capacity still counts value_pairs.
+         * pointers from get() may see a value emptied by later saves
+         */
+        void compress_cold(bool on) {
+            if (on == compress) return;
+            if (on) {
+                compress = true;
+                frontier = map.begin();
+                cool();
+                return;
+            }
+            for (auto it = map.begin(); it != frontier; ++it) {
+                it->second = decoded(*it);
             }
+            frozen.clear();
+            compress = false;
+        }
+        /**
+         * keep a blocked Bloom filter over the resident keys, so that
+         * get(), lookup() and the like reject most absent keys
+         * without walking a bucket
+         */
+        void filter_misses(bool on) {
+            filtering = on;
+            if (on) rebuild_filter();
+            else filter.reset(0);
+        }
+        /**
+         * remember up to share * capacity keys that get_or_load() found
+         * nowhere, for ttl each, unless save() or remove() of the key
+         * comes first. share 0 forgets them and stops
+         */
+        void cache_misses(double share, std::chrono::milliseconds ttl) {
+            negative.clear();
+            negative_capacity = share > 0 ? static_cast<int>(capacity * share) : 0;
+            if (share > 0 && negative_capacity < 1) negative_capacity = 1;
+            negative_ttl = ttl;
+        }
+        /**
+         * evicted value_pairs go to tier from now on (nullptr to stop),
+         * the tier must outlive the lru
+         */
+        void attach(second_tier *t) {
+            tier = t;
         }
         /**
          * return a pointer contain the value
          */
         Matrix<int> *get(const Integer &v) {
-            auto ptr = &map.at(v);
-            map.insert(pair<const Integer, Matrix<int>>(v, *ptr));
-            return ptr;
+            return get_as(v);
+        }
+        /**
+         * the same with a plain int key, no Integer is built
+         */
+        template <class K, enable_if_transparent<K, Integer, Hash, Equal> = 0>
+        Matrix<int> *get(const K &v) {
+            return get_as(v);
+        }
+        /**
+         * like get(), but on a miss look in the attached tier first, then
+         * call loader(key, value), which returns false if there is no value.
+         * what is found is saved as the newest value_pair.
+         * return nullptr if neither has it, which is remembered
+         * for a while if cache_misses() is on
+         */
+        template <class Loader>
+        Matrix<int> *get_or_load(const Integer &key, Loader loader) {
+            if (!surely_absent(key)) {
+                auto it = map.find(key);
+                if (it != map.end()) {
+                    warm(it);
+                    map.touch(it);
+                    bump(key);
+                    return &it->second;
+                }
+            }
+            if (known_absent(key)) return nullptr;
+            Matrix<int> value;
+            if (!(tier && tier->take(key, value)) && !loader(key, value)) {
+                remember_absent(key);
+                return nullptr;
+            }
+            save(value_type(key, std::move(value)));
+            return &map.find(key)->second;
+        }
+        /**
+         * like get(), but return a handle sharing the value:
+         * no payload is copied, and the handle stays valid
+         * after the value_pair is evicted or updated.
+         * writing through a pointer or row taken from get() before
+         * the lookup also changes the handle
+         */
+        Matrix<int> lookup(const Integer &v) {
+            return *touch_as(v);
+        }
+        template <class K, enable_if_transparent<K, Integer, Hash, Equal> = 0>
+        Matrix<int> lookup(const K &v) {
+            return *touch_as(v);
+        }
+        /**
+         * like lookup(), but return false instead of throwing on a miss
+         */
+        template <class K>
+        bool try_lookup(const K &v, Matrix<int> &value) {
+            if (surely_absent(v)) return false;
+            auto it = map.find(v);
+            if (it == map.end()) return false;
+            warm(it);
+            map.touch(it);
+            value = it->second;
+            return true;
+        }
+        /**
+         * the version stripe of key, it changes whenever
+         * the value connected with key may have changed
+         */
+        template <class K>
+        std::uint32_t version(const K &key) const {
+            return versions[Hash()(key) % n_versions].load(std::memory_order_acquire);
+        }
+        /**
+         * write every value_pair into a binary file, oldest first,
+         * so that load_snapshot() restores the same order.
+         * layout (native endianness):
+         *   magic[8], uint64 count,
+         *   count * { int32 key, uint64 rows, uint64 cols, rows*cols int32 }
+         */
+        void save_snapshot(const char *path) const {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            if (!out) throw runtime_error();
+            std::uint64_t count = map.size();
+            out.write(snapshot_magic(), snapshot_magic_size);
+            out.write(reinterpret_cast<const char *>(&count), sizeof(count));
+            for (auto *node = map.link.head->next; node != map.link.head; node = node->next) {
+                const Matrix<int> mat = decoded(*node->data);
+                std::int32_t key = node->data->first.val;
+                std::uint64_t shape[2] = {mat.RowSize(), mat.ColSize()};
+                out.write(reinterpret_cast<const char *>(&key), sizeof(key));
+                out.write(reinterpret_cast<const char *>(shape), sizeof(shape));
+                out.write(reinterpret_cast<const char *>(mat.Data()), mat.Size() * sizeof(int));
+            }
+            if (!out) throw runtime_error();
+        }
+        /**
+         * replace everything in the memory with the snapshot in path.
+         * buckets are sized once up front and the entries are linked
+         * in file order, so no expand() and no redual() happen.
+         * if the snapshot holds more than capacity entries,
+         * only the newest ones are kept.
+         * the entries are read into a fresh map which is swapped in
+         * at the end, so a broken file leaves the memory untouched:
+         * sizes that don't fit in the file and repeated keys throw.
+         * the entries replaced leave as removed, like in clear(),
+         * and the attached tier is cleared, nothing older than the
+         * snapshot comes back from it
+         */
+        void load_snapshot(const char *path) {
+            std::ifstream in(path, std::ios::binary);
+            char magic[snapshot_magic_size];
+            std::uint64_t count;
+            if (!in.read(magic, sizeof(magic)) || !in.read(reinterpret_cast<char *>(&count), sizeof(count))
+                || std::char_traits<char>::compare(magic, snapshot_magic(), snapshot_magic_size) != 0) {
+                throw runtime_error();
+            }
+            // every size below is checked against the bytes left, without overflow
+            const std::uint64_t entry_head = sizeof(std::int32_t) + 2 * sizeof(std::uint64_t);
+            std::streampos body = in.tellg();
+            in.seekg(0, std::ios::end);
+            std::uint64_t left = static_cast<std::uint64_t>(in.tellg() - body);
+            in.seekg(body);
+            if (!in || count > left / entry_head) throw runtime_error();
+            std::uint64_t skip = count > static_cast<std::uint64_t>(capacity) ? count - capacity : 0;
+            lmap loaded;
+            loaded.reserve(static_cast<int>(count - skip));
+            for (std::uint64_t n = 0; n < count; n++) {
+                std::int32_t key;
+                std::uint64_t shape[2];
+                if (!in.read(reinterpret_cast<char *>(&key), sizeof(key))
+                    || !in.read(reinterpret_cast<char *>(shape), sizeof(shape))) {
+                    throw runtime_error();
+                }
+                left -= entry_head;
+                if (shape[0] != 0 && shape[1] > left / sizeof(int) / shape[0]) throw runtime_error();
+                std::uint64_t bytes = shape[0] * shape[1] * sizeof(int);
+                left -= bytes;
+                if (n < skip) {
+                    in.seekg(static_cast<std::streamoff>(bytes), std::ios::cur);
+                    continue;
+                }
+                if (loaded.count(Integer(key))) throw runtime_error();
+                Matrix<int> mat(shape[0], shape[1]);
+                if (!in.read(reinterpret_cast<char *>(mat.Data()), static_cast<std::streamsize>(bytes))) {
+                    throw runtime_error();
+                }
+                loaded.insert_unique(value_type(Integer(key), std::move(mat)));
+            }
+            map.swap(loaded);
+            release_all(loaded);
+            if (tier) tier->clear();
+            bump_all();
+            negative.clear();
+            if (filtering) rebuild_filter();
+            frozen.clear();
+            frontier = map.begin();
+            cool();
         }
         /**
          * just print everything in the memory
@@ -799,7 +1873,7 @@ namespace sjtu {
          */
         void print() {
             for (auto it = map.begin(); it!=map.end(); ++it) {
-                std::cout << (*it).first.val << " " << (*it).second << std::endl;
+                std::cout << (*it).first.val << " " << decoded(*it) << std::endl;
             }
         }
     };
@@ -0,0 +1,266 @@
+#ifndef SJTU_MAPPED_IMAGE_HPP
+#define SJTU_MAPPED_IMAGE_HPP
+
+#include "lru.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sjtu {
+    /**
+     * a frozen linked_hashmap<Integer, Matrix<int> > stored in a file
+     * and used in place through mmap, nothing is deserialized.
+     * every link inside the file is an offset from the start of the file,
+     * so the image is relocatable and the pages are shared by all the
+     * processes mapping the same file.
+     * layout (native endianness):
+     *   header, uint64 buckets[bucket_count],
+     *   entry entries[entry_count] (in insertion order),
+     *   int32 payloads (each aligned to 64 bytes)
+     */
+    class mapped_image {
+        struct header {
+            char magic[8];
+            std::uint64_t bucket_count;
+            std::uint64_t entry_count;
+            std::uint64_t file_size;
+        };
+        struct entry {
+            std::int32_t key;
+            std::uint32_t hash;
+            std::uint64_t next;     // offset of the next entry in the bucket, 0 for none
+            std::uint64_t rows;
+            std::uint64_t cols;
+            std::uint64_t payload;  // offset of rows*cols int32
+        };
+
+        static const int magic_size = 8;
+        static const char *magic() {
+            return "SJTUIMG1";
+        }
+        static std::uint64_t align(std::uint64_t offset) {
+            return (offset + 63) & ~static_cast<std::uint64_t>(63);
+        }
+
+        const char *base;
+        std::uint64_t length;
+        std::uint64_t bucket_count;     // read from the header once it is checked
+        std::uint64_t entry_count;
+
+        const header &head() const {
+            return *reinterpret_cast<const header *>(base);
+        }
+        const std::uint64_t *buckets() const {
+            return reinterpret_cast<const std::uint64_t *>(base + sizeof(header));
+        }
+        std::uint64_t entries_begin() const {
+            return sizeof(header) + bucket_count * sizeof(std::uint64_t);
+        }
+
+        /**
+         * the entry at offset, throw unless offset is the start of
+         * one of the entries and its payload lies inside the file
+         */
+        const entry &entry_at(std::uint64_t offset) const {
+            std::uint64_t first = entries_begin();
+            if (offset < first || (offset - first) % sizeof(entry) != 0
+                || (offset - first) / sizeof(entry) >= entry_count) {
+                throw runtime_error();
+            }
+            const entry &e = *reinterpret_cast<const entry *>(base + offset);
+            if (e.payload % alignof(std::int32_t) != 0 || e.payload > length) throw runtime_error();
+            std::uint64_t room = (length - e.payload) / sizeof(std::int32_t);
+            if (e.rows != 0 && e.cols > room / e.rows) throw runtime_error();
+            return e;
+        }
+
+        /**
+         * check the sizes in the header without overflow,
+         * then every bucket head and every entry
+         */
+        void validate() {
+            const header &h = head();
+            if (std::char_traits<char>::compare(h.magic, magic(), magic_size) != 0 || h.file_size != length
+                || h.bucket_count == 0 || (h.bucket_count & (h.bucket_count - 1)) != 0) {
+                throw runtime_error();
+            }
+            std::uint64_t room = length - sizeof(header);
+            if (h.bucket_count > room / sizeof(std::uint64_t)) throw runtime_error();
+            room -= h.bucket_count * sizeof(std::uint64_t);
+            if (h.entry_count > room / sizeof(entry)) throw runtime_error();
+            bucket_count = h.bucket_count;
+            entry_count = h.entry_count;
+            for (std::uint64_t b = 0; b < bucket_count; b++) {
+                if (buckets()[b]) entry_at(buckets()[b]);
+            }
+            for (std::uint64_t i = 0; i < entry_count; i++) {
+                const entry &e = entry_at(entries_begin() + i * sizeof(entry));
+                if (e.next) entry_at(e.next);
+            }
+        }
+
+    public:
+        /**
+         * a read-only matrix living in the mapped pages,
+         * valid as long as the image is mapped
+         */
+        class view {
+            friend class mapped_image;
+            std::size_t n_rows;
+            std::size_t n_cols;
+            const int *data;
+            view(std::size_t rows, std::size_t cols, const int *data) : n_rows(rows), n_cols(cols), data(data) {}
+
+        public:
+            view() : n_rows(0), n_cols(0), data(nullptr) {}
+            std::size_t RowSize() const {
+                return n_rows;
+            }
+            std::size_t ColSize() const {
+                return n_cols;
+            }
+            const int *operator[](const std::size_t &Kth) const {
+                return data + Kth * n_cols;
+            }
+            bool empty() const {
+                return data == nullptr;
+            }
+            Matrix<int> to_matrix() const {
+                Matrix<int> mat(n_rows, n_cols);
+                std::copy(data, data + n_rows * n_cols, mat.Data());
+                return mat;
+            }
+        };
+
+        /**
+         * write map into an image file at path
+         */
+        static void build(const linked_hashmap<Integer, Matrix<int>, Hash, Equal> &map, const char *path) {
+            std::uint64_t count = map.size();
+            std::uint64_t bucket_count = 16;
+            while (bucket_count * 3 < count * 4) bucket_count <<= 1;
+
+            std::vector<std::uint64_t> bucket(bucket_count, 0);
+            std::vector<entry> entries;
+            entries.reserve(count);
+            std::uint64_t entry_offset = sizeof(header) + bucket_count * sizeof(std::uint64_t);
+            std::uint64_t offset = align(entry_offset + count * sizeof(entry));
+            for (auto *node = map.link.head->next; node != map.link.head; node = node->next) {
+                entry e;
+                e.key = node->data->first.val;
+                e.hash = Hash()(node->data->first);
+                e.rows = node->data->second.RowSize();
+                e.cols = node->data->second.ColSize();
+                e.payload = offset;
+                offset = align(offset + e.rows * e.cols * sizeof(std::int32_t));
+                std::uint64_t &slot = bucket[e.hash & (bucket_count - 1)];
+                e.next = slot;
+                slot = entry_offset + entries.size() * sizeof(entry);
+                entries.push_back(e);
+            }
+
+            header h;
+            std::char_traits<char>::copy(h.magic, magic(), magic_size);
+            h.bucket_count = bucket_count;
+            h.entry_count = count;
+            h.file_size = offset;
+
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            if (!out) throw runtime_error();
+            out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+            out.write(reinterpret_cast<const char *>(bucket.data()), bucket.size() * sizeof(std::uint64_t));
+            out.write(reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(entry));
+            std::uint64_t written = entry_offset + entries.size() * sizeof(entry);
+            std::vector<char> padding;
+            std::size_t k = 0;
+            for (auto *node = map.link.head->next; node != map.link.head; node = node->next, k++) {
+                const Matrix<int> &mat = node->data->second;
+                padding.assign(entries[k].payload - written, 0);
+                out.write(padding.data(), padding.size());
+                out.write(reinterpret_cast<const char *>(mat.Data()), mat.Size() * sizeof(std::int32_t));
+                written = entries[k].payload + mat.Size() * sizeof(std::int32_t);
+            }
+            padding.assign(offset - written, 0);
+            out.write(padding.data(), padding.size());
+            if (!out) throw runtime_error();
+        }
+
+        /**
+         * map the image at path read-only,
+         * throw if it is not a valid image
+         */
+        explicit mapped_image(const char *path) : base(nullptr), length(0), bucket_count(0), entry_count(0) {
+            int fd = ::open(path, O_RDONLY);
+            if (fd < 0) throw runtime_error();
+            struct stat st;
+            if (::fstat(fd, &st) != 0 || static_cast<std::uint64_t>(st.st_size) < sizeof(header)) {
+                ::close(fd);
+                throw runtime_error();
+            }
+            length = st.st_size;
+            void *addr = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (addr == MAP_FAILED) throw runtime_error();
+            base = static_cast<const char *>(addr);
+            try {
+                validate();
+            } catch (...) {
+                ::munmap(const_cast<char *>(base), length);
+                throw;
+            }
+            ::madvise(const_cast<char *>(base), length, MADV_RANDOM);
+        }
+        mapped_image(const mapped_image &other) = delete;
+        mapped_image &operator=(const mapped_image &other) = delete;
+        ~mapped_image() {
+            ::munmap(const_cast<char *>(base), length);
+        }
+
+        std::size_t size() const {
+            return entry_count;
+        }
+        bool empty() const {
+            return size() == 0;
+        }
+
+        /**
+         * return the matrix connected with key directly from the mapped pages,
+         * an empty view if not found.
+         * the file is shared, so every offset is checked again on the way
+         * (and a chain longer than the image is a loop): throw if it went bad
+         */
+        view find(const Integer &key) const {
+            std::uint32_t hash = Hash()(key);
+            std::uint64_t offset = buckets()[hash & (bucket_count - 1)];
+            for (std::uint64_t steps = 0; offset; steps++) {
+                if (steps >= entry_count) throw runtime_error();
+                const entry &e = entry_at(offset);
+                if (e.hash == hash && e.key == key.val) {
+                    return view(e.rows, e.cols, reinterpret_cast<const int *>(base + e.payload));
+                }
+                offset = e.next;
+            }
+            return view();
+        }
+        size_t count(const Integer &key) const {
+            return !find(key).empty();
+        }
+        /**
+         * if the key not found, throw
+         */
+        view at(const Integer &key) const {
+            view v = find(key);
+            if (v.empty()) throw index_out_of_bound();
+            return v;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,260 @@
+#ifndef SJTU_MATRIX_KERNEL_HPP
+#define SJTU_MATRIX_KERNEL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SJTU_MATRIX_X86 1
+#include <immintrin.h>
+#endif
+
+/**
+ * Raw multiplication kernels on row-major buffers,
+ * used by the Matrix operators.
+ * Every kernel computes c[m x n] += a[m x k] * b[k x n] (or b given
+ * transposed). The generic kernels still sum each c[i][j] over k in
+ * increasing order, so floating point results are the same as the
+ * textbook i-j-k loop; the int32 kernels accumulate modulo 2^32.
+ */
+namespace matrix_kernel {
+
+const size_t kBlockK = 256;
+const size_t kBlockN = 256;
+/**
+ * Below this many multiply-adds packing costs more than it saves.
+ */
+const size_t kPackThreshold = 32 * 32 * 32;
+
+/**
+ * Cache-blocked i-k-j loop: the innermost loop streams one row of b
+ * and one row of c, which the compiler vectorizes for any _Td.
+ */
+template<typename _Td>
+void GemmBlocked(const _Td *a, const _Td *b, _Td *c, size_t m, size_t n, size_t k)
+{
+    for (size_t k0 = 0; k0 < k; k0 += kBlockK) {
+        size_t k1 = std::min(k, k0 + kBlockK);
+        for (size_t j0 = 0; j0 < n; j0 += kBlockN) {
+            size_t j1 = std::min(n, j0 + kBlockN);
+            for (size_t i = 0; i < m; ++i) {
+                _Td *ci = c + i * n;
+                for (size_t p = k0; p < k1; ++p) {
+                    const _Td aip = a[i * k + p];
+                    const _Td *bp = b + p * n;
+                    for (size_t j = j0; j < j1; ++j) {
+                        ci[j] += aip * bp[j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * c = a * Transpose(bt), where bt is n x k: both operands are read
+ * along contiguous rows, four output columns at a time.
+ */
+template<typename _Td>
+void GemmTransposed(const _Td *a, const _Td *bt, _Td *c, size_t m, size_t n, size_t k)
+{
+    for (size_t i = 0; i < m; ++i) {
+        const _Td *ai = a + i * k;
+        size_t j = 0;
+        for (; j + 4 <= n; j += 4) {
+            const _Td *b0 = bt + j * k, *b1 = b0 + k, *b2 = b1 + k, *b3 = b2 + k;
+            _Td s0 = c[i * n + j], s1 = c[i * n + j + 1], s2 = c[i * n + j + 2], s3 = c[i * n + j + 3];
+            for (size_t p = 0; p < k; ++p) {
+                s0 += ai[p] * b0[p];
+                s1 += ai[p] * b1[p];
+                s2 += ai[p] * b2[p];
+                s3 += ai[p] * b3[p];
+            }
+            c[i * n + j] = s0;
+            c[i * n + j + 1] = s1;
+            c[i * n + j + 2] = s2;
+            c[i * n + j + 3] = s3;
+        }
+        for (; j < n; ++j) {
+            const _Td *bj = bt + j * k;
+            _Td s = c[i * n + j];
+            for (size_t p = 0; p < k; ++p) {
+                s += ai[p] * bj[p];
+            }
+            c[i * n + j] = s;
+        }
+    }
+}
+
+template<typename _Td>
+inline void Gemm(const _Td *a, const _Td *b, _Td *c, size_t m, size_t n, size_t k)
+{
+    GemmBlocked(a, b, c, m, n, k);
+}
+
+#ifdef SJTU_MATRIX_X86
+
+/**
+ * Copy the block b[k0, k1) x [j0, j1) into panels of _Nr columns,
+ * panel after panel, each (k1 - k0) rows of _Nr ints, zero padded.
+ */
+template<size_t _Nr>
+inline void PackB(const int *b, size_t n, size_t k0, size_t k1, size_t j0, size_t j1, int *packed)
+{
+    for (size_t q = j0; q < j1; q += _Nr) {
+        size_t w = std::min(_Nr, j1 - q);
+        for (size_t p = k0; p < k1; ++p) {
+            const int *src = b + p * n + q;
+            size_t t = 0;
+            for (; t < w; ++t) *packed++ = src[t];
+            for (; t < _Nr; ++t) *packed++ = 0;
+        }
+    }
+}
+
+/**
+ * 4 x 16 int32 micro-kernel: the 4 x 16 block of c is held in eight ymm
+ * accumulators across the whole k block, int32 lanes wrap like int.
+ * Rows past mr reuse the last valid row and are discarded.
+ */
+__attribute__((target("avx2")))
+inline void MicroKernelAvx2(const int *a, size_t lda, const int *bp, size_t kc, int *c, size_t ldc, size_t mr, size_t nr)
+{
+    const int *a0 = a, *a1 = a + std::min<size_t>(1, mr - 1) * lda;
+    const int *a2 = a + std::min<size_t>(2, mr - 1) * lda, *a3 = a + std::min<size_t>(3, mr - 1) * lda;
+    __m256i c00 = _mm256_setzero_si256(), c01 = c00, c10 = c00, c11 = c00;
+    __m256i c20 = c00, c21 = c00, c30 = c00, c31 = c00;
+    for (size_t p = 0; p < kc; ++p, bp += 16) {
+        __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bp));
+        __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bp + 8));
+        __m256i av = _mm256_set1_epi32(a0[p]);
+        c00 = _mm256_add_epi32(c00, _mm256_mullo_epi32(av, b0));
+        c01 = _mm256_add_epi32(c01, _mm256_mullo_epi32(av, b1));
+        av = _mm256_set1_epi32(a1[p]);
+        c10 = _mm256_add_epi32(c10, _mm256_mullo_epi32(av, b0));
+        c11 = _mm256_add_epi32(c11, _mm256_mullo_epi32(av, b1));
+        av = _mm256_set1_epi32(a2[p]);
+        c20 = _mm256_add_epi32(c20, _mm256_mullo_epi32(av, b0));
+        c21 = _mm256_add_epi32(c21, _mm256_mullo_epi32(av, b1));
+        av = _mm256_set1_epi32(a3[p]);
+        c30 = _mm256_add_epi32(c30, _mm256_mullo_epi32(av, b0));
+        c31 = _mm256_add_epi32(c31, _mm256_mullo_epi32(av, b1));
+    }
+    alignas(32) int acc[4][16];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(acc[0]), c00);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(acc[0] + 8), c01);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(acc[1]), c10);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(acc[1] + 8), c11);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(acc[2]), c20);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(acc[2] + 8), c21);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(acc[3]), c30);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(acc[3] + 8), c31);
+    for (size_t r = 0; r < mr; ++r) {
+        int *cr = c + r * ldc;
+        for (size_t t = 0; t < nr; ++t) {
+            cr[t] = static_cast<int>(static_cast<unsigned>(cr[t]) + static_cast<unsigned>(acc[r][t]));
+        }
+    }
+}
+
+/**
+ * 4 x 32 int32 micro-kernel on zmm registers, same contract as above.
+ */
+__attribute__((target("avx512f")))
+inline void MicroKernelAvx512(const int *a, size_t lda, const int *bp, size_t kc, int *c, size_t ldc, size_t mr, size_t nr)
+{
+    const int *a0 = a, *a1 = a + std::min<size_t>(1, mr - 1) * lda;
+    const int *a2 = a + std::min<size_t>(2, mr - 1) * lda, *a3 = a + std::min<size_t>(3, mr - 1) * lda;
+    __m512i c00 = _mm512_setzero_si512(), c01 = c00, c10 = c00, c11 = c00;
+    __m512i c20 = c00, c21 = c00, c30 = c00, c31 = c00;
+    for (size_t p = 0; p < kc; ++p, bp += 32) {
+        __m512i b0 = _mm512_loadu_si512(bp);
+        __m512i b1 = _mm512_loadu_si512(bp + 16);
+        __m512i av = _mm512_set1_epi32(a0[p]);
+        c00 = _mm512_add_epi32(c00, _mm512_mullo_epi32(av, b0));
+        c01 = _mm512_add_epi32(c01, _mm512_mullo_epi32(av, b1));
+        av = _mm512_set1_epi32(a1[p]);
+        c10 = _mm512_add_epi32(c10, _mm512_mullo_epi32(av, b0));
+        c11 = _mm512_add_epi32(c11, _mm512_mullo_epi32(av, b1));
+        av = _mm512_set1_epi32(a2[p]);
+        c20 = _mm512_add_epi32(c20, _mm512_mullo_epi32(av, b0));
+        c21 = _mm512_add_epi32(c21, _mm512_mullo_epi32(av, b1));
+        av = _mm512_set1_epi32(a3[p]);
+        c30 = _mm512_add_epi32(c30, _mm512_mullo_epi32(av, b0));
+        c31 = _mm512_add_epi32(c31, _mm512_mullo_epi32(av, b1));
+    }
+    alignas(64) int acc[4][32];
+    _mm512_store_si512(acc[0], c00);
+    _mm512_store_si512(acc[0] + 16, c01);
+    _mm512_store_si512(acc[1], c10);
+    _mm512_store_si512(acc[1] + 16, c11);
+    _mm512_store_si512(acc[2], c20);
+    _mm512_store_si512(acc[2] + 16, c21);
+    _mm512_store_si512(acc[3], c30);
+    _mm512_store_si512(acc[3] + 16, c31);
+    for (size_t r = 0; r < mr; ++r) {
+        int *cr = c + r * ldc;
+        for (size_t t = 0; t < nr; ++t) {
+            cr[t] = static_cast<int>(static_cast<unsigned>(cr[t]) + static_cast<unsigned>(acc[r][t]));
+        }
+    }
+}
+
+typedef void (*MicroKernel)(const int *, size_t, const int *, size_t, int *, size_t, size_t, size_t);
+
+/**
+ * Packed GEMM driver: b is packed once per (k, n) block and then
+ * swept by 4-row strips of a through the micro-kernel.
+ */
+template<size_t _Nr>
+void GemmPacked(MicroKernel kernel, const int *a, const int *b, int *c, size_t m, size_t n, size_t k)
+{
+    std::vector<int> packed(kBlockK * (kBlockN + _Nr));
+    for (size_t k0 = 0; k0 < k; k0 += kBlockK) {
+        size_t k1 = std::min(k, k0 + kBlockK), kc = k1 - k0;
+        for (size_t j0 = 0; j0 < n; j0 += kBlockN) {
+            size_t j1 = std::min(n, j0 + kBlockN);
+            PackB<_Nr>(b, n, k0, k1, j0, j1, packed.data());
+            for (size_t i = 0; i < m; i += 4) {
+                size_t mr = std::min<size_t>(4, m - i);
+                const int *bp = packed.data();
+                for (size_t q = j0; q < j1; q += _Nr, bp += kc * _Nr) {
+                    kernel(a + i * k + k0, k, bp, kc, c + i * n + q, n, mr, std::min(_Nr, j1 - q));
+                }
+            }
+        }
+    }
+}
+
+enum CpuLevel { kScalar = 0, kAvx2 = 1, kAvx512 = 2 };
+
+inline CpuLevel DetectCpu()
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return kAvx512;
+    if (__builtin_cpu_supports("avx2")) return kAvx2;
+    return kScalar;
+}
+
+/**
+ * int32 product: the widest micro-kernel the running CPU supports,
+ * chosen once at the first call.
+ */
+inline void Gemm(const int *a, const int *b, int *c, size_t m, size_t n, size_t k)
+{
+    static const CpuLevel level = DetectCpu();
+    if (m * n * k < kPackThreshold || level == kScalar) {
+        GemmBlocked(a, b, c, m, n, k);
+    } else if (level == kAvx512) {
+        GemmPacked<32>(MicroKernelAvx512, a, b, c, m, n, k);
+    } else {
+        GemmPacked<16>(MicroKernelAvx2, a, b, c, m, n, k);
+    }
+}
+
+#endif
+
+}
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef SJTU_RECLAIMER_HPP
+#define SJTU_RECLAIMER_HPP
+
+#include "lru.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sjtu {
+    /**
+     * a value_reclaimer that destroys the retired values on its own
+     * thread, so the cost of freeing big buffers never lands on the
+     * thread calling lru::save()
+     */
+    class background_reclaimer : public value_reclaimer {
+        std::mutex lock;
+        std::condition_variable ready;
+        std::vector<std::vector<Matrix<int> > > queue;
+        bool stopping;
+        std::thread worker;
+
+        void run() {
+            std::vector<std::vector<Matrix<int> > > batches;
+            std::unique_lock<std::mutex> guard(lock);
+            for (;;) {
+                ready.wait(guard, [this] { return stopping || !queue.empty(); });
+                if (queue.empty()) return;
+                batches.swap(queue);
+                guard.unlock();
+                batches.clear();
+                guard.lock();
+            }
+        }
+
+    public:
+        background_reclaimer() : stopping(false), worker(&background_reclaimer::run, this) {}
+        background_reclaimer(const background_reclaimer &other) = delete;
+        background_reclaimer &operator=(const background_reclaimer &other) = delete;
+        /**
+         * destroy whatever is left, then stop
+         */
+        ~background_reclaimer() {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                stopping = true;
+            }
+            ready.notify_one();
+            worker.join();
+        }
+
+        void retire(std::vector<Matrix<int> > &values) override {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                queue.emplace_back();
+                queue.back().swap(values);
+            }
+            ready.notify_one();
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,399 @@
+#ifndef SJTU_ROBIN_HOOD_HPP
+#define SJTU_ROBIN_HOOD_HPP
+
+#include "lru.hpp"
+
+#include <cstdint>
+#include <utility>
+
+namespace sjtu {
+    /**
+     * an open-addressed Robin Hood table of Node pointers, keyed by
+     * node->data->first. a slot keeps the hash of its key and its
+     * distance from the home slot, and an insertion takes the slot of
+     * any key nearer to home than itself, so probe lengths stay short
+     * up to a load factor of 0.9.
+     * remove() shifts the rest of the run one slot back, so there are
+     * no tombstones however many keys come and go.
+     * the table doesn't own the nodes
+     */
+    template <class Key, class Node, class Hash, class Equal>
+    class robin_index {
+        struct slot {
+            Node *node;
+            std::uint32_t hash;
+            std::int32_t dist;      // -1 for an empty slot
+        };
+
+        slot *slots;
+        std::uint32_t mask;         // capacity - 1, capacity is a power of two
+        int size;
+        double load_factor;
+
+        static std::uint32_t capacity_for(int n, double load_factor) {
+            std::uint32_t capacity = 8;
+            while (capacity * load_factor < n + 1) capacity <<= 1;
+            return capacity;
+        }
+        static slot *alloc(std::uint32_t capacity) {
+            slot *s = new slot[capacity];
+            for (std::uint32_t i = 0; i < capacity; i++) s[i].dist = -1;
+            return s;
+        }
+
+        /**
+         * put node into the table, its key must be absent
+         */
+        void place(Node *node, std::uint32_t hash) {
+            slot cur = {node, hash, 0};
+            for (std::uint32_t i = hash & mask;; i = (i + 1) & mask, cur.dist++) {
+                if (slots[i].dist < 0) {
+                    slots[i] = cur;
+                    return;
+                }
+                if (slots[i].dist < cur.dist) std::swap(slots[i], cur);
+            }
+        }
+
+        /**
+         * the slot holding key, -1 if none. a run is over once a slot
+         * is nearer to its home than key would be
+         */
+        template <class K>
+        std::int64_t locate(const K &key) const {
+            std::uint32_t hash = static_cast<std::uint32_t>(Hash()(key));
+            std::int32_t dist = 0;
+            for (std::uint32_t i = hash & mask;; i = (i + 1) & mask, dist++) {
+                const slot &s = slots[i];
+                if (s.dist < dist) return -1;
+                if (s.hash == hash && Equal()(s.node->data->first, key)) return i;
+            }
+        }
+
+        void rehash(std::uint32_t capacity) {
+            slot *old = slots;
+            std::uint32_t old_capacity = mask + 1;
+            slots = alloc(capacity);
+            mask = capacity - 1;
+            for (std::uint32_t i = 0; i < old_capacity; i++) {
+                if (old[i].dist >= 0) place(old[i].node, old[i].hash);
+            }
+            delete[] old;
+        }
+
+    public:
+        /**
+         * load_factor is capped at 0.9
+         */
+        explicit robin_index(int capacity = 0, double load_factor = 0.875)
+            : size(0), load_factor(load_factor > 0.9 ? 0.9 : load_factor) {
+            std::uint32_t n = capacity_for(capacity, this->load_factor);
+            slots = alloc(n);
+            mask = n - 1;
+        }
+        robin_index(const robin_index &other) = delete;
+        /**
+         * steal the slots, other is left with the fewest
+         * fresh ones and is an empty index afterwards, which may throw
+         */
+        robin_index(robin_index &&other) : robin_index(0, other.load_factor) {
+            swap(other);
+        }
+        robin_index &operator=(const robin_index &other) = delete;
+        robin_index &operator=(robin_index &&other) noexcept {
+            swap(other);
+            return *this;
+        }
+        ~robin_index() {
+            delete[] slots;
+        }
+        void swap(robin_index &other) noexcept {
+            std::swap(slots, other.slots);
+            std::swap(mask, other.mask);
+            std::swap(size, other.size);
+            std::swap(load_factor, other.load_factor);
+        }
+
+        int count() const {
+            return size;
+        }
+        std::uint32_t capacity() const {
+            return mask + 1;
+        }
+
+        /**
+         * make room for n nodes, so that the next
+         * n - size insertions never rehash
+         */
+        void reserve(int n) {
+            std::uint32_t need = capacity_for(n, load_factor);
+            if (need > mask + 1) rehash(need);
+        }
+
+        template <class K>
+        Node *find(const K &key) const {
+            std::int64_t i = locate(key);
+            return i < 0 ? nullptr : slots[i].node;
+        }
+
+        /**
+         * add node, whose key must be absent
+         */
+        void insert(Node *node) {
+            if (size + 1 > (mask + 1) * load_factor) rehash((mask + 1) * 2);
+            place(node, static_cast<std::uint32_t>(Hash()(node->data->first)));
+            size++;
+        }
+
+        /**
+         * drop the node of key and shift the rest of its run back
+         * by one, return it (nullptr if absent)
+         */
+        template <class K>
+        Node *remove(const K &key) {
+            std::int64_t at = locate(key);
+            if (at < 0) return nullptr;
+            Node *node = slots[at].node;
+            std::uint32_t i = static_cast<std::uint32_t>(at);
+            for (std::uint32_t j = (i + 1) & mask; slots[j].dist > 0; i = j, j = (j + 1) & mask) {
+                slots[i] = slots[j];
+                slots[i].dist--;
+            }
+            slots[i].dist = -1;
+            size--;
+            return node;
+        }
+
+        void clear() {
+            for (std::uint32_t i = 0; i <= mask; i++) slots[i].dist = -1;
+            size = 0;
+        }
+
+        /**
+         * the longest distance from home, for tests and tuning
+         */
+        int max_distance() const {
+            int longest = 0;
+            for (std::uint32_t i = 0; i <= mask; i++) {
+                if (slots[i].dist > longest) longest = slots[i].dist;
+            }
+            return longest;
+        }
+    };
+
+    /**
+     * linked_hashmap with a robin_index in place of the chained buckets:
+     * an entry is its link node and one 16-byte slot, instead of two
+     * nodes plus a list head and sentinel per bucket.
+     * the interface (and the iterators) are those of linked_hashmap
+     */
+    template <
+        class Key,
+        class T,
+        class Hash = std::hash<Key>,
+        class Equal = std::equal_to<Key> >
+    class linked_robin_hashmap {
+    public:
+        typedef pair<const Key, T> value_type;
+        typedef double_list<value_type> List;
+        typedef typename linked_hashmap<Key, T, Hash, Equal>::iterator iterator;
+        typedef typename linked_hashmap<Key, T, Hash, Equal>::const_iterator const_iterator;
+
+        robin_index<Key, typename List::Node, Hash, Equal> index;
+        List link;
+
+    private:
+        iterator append(typename List::Node *obj) {
+            link.link_tail(obj);
+            index.insert(obj);
+            return iterator(typename List::iterator(obj));
+        }
+
+    public:
+        linked_robin_hashmap() {
+        }
+        /**
+         * room for capacity entries up front
+         */
+        explicit linked_robin_hashmap(int capacity, double load_factor = 0.875) : index(capacity, load_factor) {
+        }
+        linked_robin_hashmap(const linked_robin_hashmap &other) : index(other.size()) {
+            for (auto *node = other.link.head->next; node != other.link.head; node = node->next) {
+                append(new typename List::Node(*node->data));
+            }
+        }
+        linked_robin_hashmap(linked_robin_hashmap &&other)
+            : index(std::move(other.index)), link(std::move(other.link)) {
+        }
+        linked_robin_hashmap &operator=(const linked_robin_hashmap &other) {
+            if (this == &other) return *this;
+            linked_robin_hashmap tmp(other);
+            swap(tmp);
+            return *this;
+        }
+        linked_robin_hashmap &operator=(linked_robin_hashmap &&other) noexcept {
+            swap(other);
+            return *this;
+        }
+        void swap(linked_robin_hashmap &other) noexcept {
+            index.swap(other.index);
+            link.swap(other.link);
+        }
+
+        /**
+         * call fn(value_pair) for every element in insertion order
+         * (oldest first). fn must not insert or remove.
+         */
+        template <class Fn>
+        void for_each(Fn fn) {
+            link.for_each(fn);
+        }
+        template <class Fn>
+        void for_each(Fn fn) const {
+            link.for_each([&fn](const value_type &value) { fn(value); });
+        }
+        template <class Fn>
+        void for_each_batch(Fn fn, size_t batch = 16) const {
+            link.for_each_batch(fn, batch);
+        }
+
+        /**
+         * return the value connected with the key,
+         * if the key not found, throw
+         */
+        T &at(const Key &key) {
+            auto *obj = index.find(key);
+            if (!obj) {
+                throw index_out_of_bound();
+            }
+            return obj->data->second;
+        }
+        const T &at(const Key &key) const {
+            auto *obj = index.find(key);
+            if (!obj) {
+                throw index_out_of_bound();
+            }
+            return obj->data->second;
+        }
+        template <class K, enable_if_transparent<K, Key, Hash, Equal> = 0>
+        T &at(const K &key) {
+            auto *obj = index.find(key);
+            if (!obj) {
+                throw index_out_of_bound();
+            }
+            return obj->data->second;
+        }
+        template <class K, enable_if_transparent<K, Key, Hash, Equal> = 0>
+        const T &at(const K &key) const {
+            auto *obj = index.find(key);
+            if (!obj) {
+                throw index_out_of_bound();
+            }
+            return obj->data->second;
+        }
+        T &operator[](const Key &key) {
+            return at(key);
+        }
+        const T &operator[](const Key &key) const {
+            return at(key);
+        }
+
+        iterator begin() {
+            return iterator(link.begin());
+        }
+        const_iterator cbegin() const {
+            return const_iterator(link.begin());
+        }
+        iterator end() {
+            return iterator(link.end());
+        }
+        const_iterator cend() const {
+            return const_iterator(link.end());
+        }
+        bool empty() const {
+            return index.count() == 0;
+        }
+        size_t size() const {
+            return index.count();
+        }
+
+        void clear() {
+            index.clear();
+            link.clear();
+        }
+        void reserve(int n) {
+            index.reserve(n);
+        }
+
+        /**
+         * insert the value_pair as the newest element and return true,
+         * or, if the key exists, update its value, make it the newest
+         * and return false
+         */
+        pair<iterator, bool> insert(const value_type &value) {
+            auto *obj = index.find(value.first);
+            if (obj) {
+                obj->data->second = value.second;
+                link.move_tail(typename List::iterator(obj));
+                return pair<iterator, bool>(iterator(typename List::iterator(obj)), false);
+            }
+            return pair<iterator, bool>(append(new typename List::Node(value)), true);
+        }
+        /**
+         * append a value_pair whose key is known to be absent
+         */
+        iterator insert_unique(value_type &&value) {
+            return append(new typename List::Node(std::move(value)));
+        }
+
+        /**
+         * replace everything with [first, last) (or range),
+         * the keys must be distinct
+         */
+        template <class ForwardIt>
+        void build_from(ForwardIt first, ForwardIt last) {
+            clear();
+            int n = 0;
+            for (ForwardIt it = first; it != last; ++it) n++;
+            reserve(n);
+            for (; first != last; ++first) append(new typename List::Node(value_type(*first)));
+        }
+        template <class Range>
+        void build_from(const Range &range) {
+            build_from(range.begin(), range.end());
+        }
+
+        /**
+         * move the value_pair pointed by the iterator to the newest end
+         */
+        void touch(iterator pos) {
+            link.move_tail(pos.ptr);
+        }
+        /**
+         * erase the value_pair pointed by the iterator
+         */
+        void remove(iterator pos) {
+            index.remove(pos->first);
+            link.erase(pos.ptr);
+        }
+
+        size_t count(const Key &key) const {
+            return index.find(key) != nullptr;
+        }
+        template <class K, enable_if_transparent<K, Key, Hash, Equal> = 0>
+        size_t count(const K &key) const {
+            return index.find(key) != nullptr;
+        }
+        iterator find(const Key &key) {
+            auto *obj = index.find(key);
+            return obj ? iterator(typename List::iterator(obj)) : end();
+        }
+        template <class K, enable_if_transparent<K, Key, Hash, Equal> = 0>
+        iterator find(const K &key) {
+            auto *obj = index.find(key);
+            return obj ? iterator(typename List::iterator(obj)) : end();
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,275 @@
+#ifndef SJTU_SPILL_TIER_HPP
+#define SJTU_SPILL_TIER_HPP
+
+#include "lru.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace sjtu {
+    /**
+     * a second_tier on local disk, for values that are cheaper to read
+     * back than to recompute.
+     * values are appended to log segments through a write buffer flushed
+     * in batches, and an in-memory index maps every key to its record.
+     * a segment that is mostly dead is compacted (its live records are
+     * appended again), and while the segments exceed the budget the oldest
+     * one is dropped with everything in it.
+     * the files are scratch space: they are removed with the tier.
+     * record layout (native endianness):
+     *   int32 key, uint32 reserved, uint64 rows, uint64 cols, rows*cols int32
+     */
+    class spill_tier : public second_tier {
+        struct record {
+            std::int32_t key;
+            std::uint32_t reserved;
+            std::uint64_t rows;
+            std::uint64_t cols;
+        };
+        struct location {
+            std::uint32_t segment;
+            std::uint64_t offset;
+            std::uint64_t bytes;    // the record and its payload
+        };
+        struct segment {
+            std::uint32_t id;
+            int fd;
+            std::uint64_t size;     // bytes appended, buffered ones included
+            std::uint64_t live;     // bytes still in the index
+        };
+
+        std::string dir;
+        std::uint64_t budget;
+        std::uint64_t segment_size;
+        size_t batch;
+        std::deque<segment> segments;   // oldest first, the back one is appended to
+        std::uint32_t next_id;
+        std::vector<char> buffer;       // the tail of the back segment not written yet
+        std::uint64_t buffer_offset;    // where buffer starts in that segment
+        std::uint64_t disk;
+        hashmap<Integer, location, Hash, Equal> index;
+
+        std::string path_of(std::uint32_t id) const {
+            return dir + "/spill-" + std::to_string(id) + ".log";
+        }
+
+        segment *find_segment(std::uint32_t id) {
+            for (auto &s : segments) {
+                if (s.id == id) return &s;
+            }
+            return nullptr;
+        }
+
+        static void write_all(int fd, const char *p, std::uint64_t n, std::uint64_t offset) {
+            while (n) {
+                ssize_t done = ::pwrite(fd, p, n, offset);
+                if (done <= 0) throw runtime_error();
+                p += done;
+                n -= done;
+                offset += done;
+            }
+        }
+        static void read_all(int fd, char *p, std::uint64_t n, std::uint64_t offset) {
+            while (n) {
+                ssize_t done = ::pread(fd, p, n, offset);
+                if (done <= 0) throw runtime_error();
+                p += done;
+                n -= done;
+                offset += done;
+            }
+        }
+
+        void open_segment() {
+            segment s;
+            s.id = next_id++;
+            s.fd = ::open(path_of(s.id).c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if (s.fd < 0) throw runtime_error();
+            s.size = s.live = 0;
+            segments.push_back(s);
+            buffer_offset = 0;
+        }
+
+        void close_segment(std::uint32_t id) {
+            for (auto it = segments.begin(); it != segments.end(); ++it) {
+                if (it->id == id) {
+                    ::close(it->fd);
+                    ::unlink(path_of(id).c_str());
+                    disk -= it->size;
+                    segments.erase(it);
+                    return;
+                }
+            }
+        }
+
+        void append(std::int32_t key, std::uint64_t rows, std::uint64_t cols, const int *payload) {
+            std::uint64_t bytes = sizeof(record) + rows * cols * sizeof(std::int32_t);
+            if (segments.empty() || (segments.back().size > 0 && segments.back().size + bytes > segment_size)) {
+                flush();
+                open_segment();
+            }
+            segment &s = segments.back();
+            record r = {key, 0, rows, cols};
+            const char *head = reinterpret_cast<const char *>(&r);
+            const char *body = reinterpret_cast<const char *>(payload);
+            buffer.insert(buffer.end(), head, head + sizeof(r));
+            buffer.insert(buffer.end(), body, body + (bytes - sizeof(r)));
+            location loc = {s.id, s.size, bytes};
+            index.insert(pair<const Integer, location>(Integer(key), loc));
+            s.size += bytes;
+            s.live += bytes;
+            disk += bytes;
+            if (buffer.size() >= batch) flush();
+        }
+
+        void read(const location &loc, record &r, int *payload) {
+            segment &s = *find_segment(loc.segment);
+            if (&s == &segments.back() && loc.offset >= buffer_offset) {
+                const char *p = buffer.data() + (loc.offset - buffer_offset);
+                std::memcpy(&r, p, sizeof(r));
+                if (payload) std::memcpy(payload, p + sizeof(r), loc.bytes - sizeof(r));
+                return;
+            }
+            read_all(s.fd, reinterpret_cast<char *>(&r), sizeof(r), loc.offset);
+            if (payload) read_all(s.fd, reinterpret_cast<char *>(payload), loc.bytes - sizeof(r), loc.offset + sizeof(r));
+        }
+
+        void drop(const location &loc) {
+            find_segment(loc.segment)->live -= loc.bytes;
+        }
+
+        /**
+         * call fn(key, location, live) for every record of a sealed segment
+         */
+        template <class Fn>
+        void scan(std::uint32_t id, Fn fn) {
+            segment s = *find_segment(id);
+            for (std::uint64_t offset = 0; offset < s.size;) {
+                record r;
+                read_all(s.fd, reinterpret_cast<char *>(&r), sizeof(r), offset);
+                location loc = {id, offset, sizeof(r) + r.rows * r.cols * sizeof(std::int32_t)};
+                auto it = index.find(Integer(r.key));
+                bool live = it != index.end() && it->second.segment == id && it->second.offset == offset;
+                fn(r, loc, live);
+                offset += loc.bytes;
+            }
+        }
+
+        /**
+         * append the live records of a sealed segment again, then delete it
+         */
+        void compact(std::uint32_t id) {
+            std::vector<int> payload;
+            scan(id, [&](const record &r, const location &loc, bool live) {
+                if (!live) return;
+                record copy;
+                payload.resize(r.rows * r.cols);
+                read(loc, copy, payload.data());
+                append(r.key, r.rows, r.cols, payload.data());
+            });
+            close_segment(id);
+        }
+
+        /**
+         * delete a sealed segment with everything in it
+         */
+        void discard(std::uint32_t id) {
+            scan(id, [&](const record &r, const location &, bool live) {
+                if (live) index.remove(Integer(r.key));
+            });
+            close_segment(id);
+        }
+
+        /**
+         * compact the sealed segments that are more than half dead,
+         * then drop the oldest ones while over budget
+         */
+        void shrink() {
+            std::vector<std::uint32_t> sealed;
+            for (size_t i = 0; i + 1 < segments.size(); i++) {
+                if (segments[i].live * 2 < segments[i].size) sealed.push_back(segments[i].id);
+            }
+            for (std::uint32_t id : sealed) compact(id);
+            while (disk > budget && segments.size() > 1) discard(segments.front().id);
+        }
+
+    public:
+        /**
+         * keep at most budget bytes of segments under the directory dir,
+         * each segment up to segment_size bytes, writing batch bytes at once
+         */
+        spill_tier(const std::string &dir, std::uint64_t budget,
+                   std::uint64_t segment_size = 16 << 20, size_t batch = 1 << 20)
+            : dir(dir), budget(budget), segment_size(segment_size), batch(batch),
+              next_id(0), buffer_offset(0), disk(0) {}
+        spill_tier(const spill_tier &other) = delete;
+        spill_tier &operator=(const spill_tier &other) = delete;
+        ~spill_tier() {
+            while (!segments.empty()) close_segment(segments.front().id);
+        }
+
+        size_t size() const {
+            return index.size;
+        }
+        /**
+         * bytes held by the segments, dead records included
+         */
+        std::uint64_t bytes() const {
+            return disk;
+        }
+
+        void put(const Integer &key, const Matrix<int> &value) override {
+            erase(key);
+            append(key.val, value.RowSize(), value.ColSize(), value.Data());
+            if (disk > budget) shrink();
+        }
+
+        bool take(const Integer &key, Matrix<int> &value) override {
+            auto it = index.find(key);
+            if (it == index.end()) return false;
+            location loc = it->second;
+            record r;
+            read(loc, r, nullptr);
+            Matrix<int> mat(r.rows, r.cols);
+            read(loc, r, mat.Data());
+            value = std::move(mat);
+            drop(loc);
+            index.remove(key);
+            return true;
+        }
+
+        void erase(const Integer &key) override {
+            auto it = index.find(key);
+            if (it == index.end()) return;
+            drop(it->second);
+            index.remove(key);
+        }
+
+        /**
+         * drop every record and delete the segments
+         */
+        void clear() override {
+            while (!segments.empty()) close_segment(segments.front().id);
+            index.clear();
+            buffer.clear();
+            buffer_offset = 0;
+        }
+
+        /**
+         * write the buffered records out
+         */
+        void flush() {
+            if (buffer.empty()) return;
+            write_all(segments.back().fd, buffer.data(), buffer.size(), buffer_offset);
+            buffer_offset += buffer.size();
+            buffer.clear();
+        }
+    };
+}
+
+#endif
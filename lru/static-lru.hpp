@@ -0,0 +1,251 @@
+#ifndef SJTU_STATIC_LRU_HPP
+#define SJTU_STATIC_LRU_HPP
+
+#include "lru.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__GNUC__) && defined(__SSE2__)
+#define SJTU_STATIC_LRU_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace sjtu {
+    /**
+     * an lru of at most N value_pairs whose storage is all inside the
+     * object: keys, values, the order and the bucket chains are arrays
+     * sized from N, linked by the smallest unsigned type that holds N.
+     * nothing is allocated (the values may allocate themselves), so it
+     * can live on the stack or as a member. Key and Value must be default
+     * constructible (e.g. int keys rather than Integer), and it is
+     * constexpr constructible when both are literal types.
+     * links are slot + 1 with 0 for none, so a zeroed object is an empty
+     * cache. up to 16 slots a lookup compares the key with every slot
+     * into a bitmask without branching (four slots per SSE2 compare for
+     * 32-bit integral keys), past that it walks a chain of power-of-two
+     * buckets.
+     */
+    template <
+        class Key,
+        class Value,
+        size_t N,
+        class Hash = std::hash<Key>,
+        class Equal = std::equal_to<Key> >
+    class static_lru {
+        static_assert(N > 0 && N < 0xffffffffu, "N must fit in 32 bits");
+
+        using link_t = typename std::conditional<(N < 0xff), std::uint8_t,
+            typename std::conditional<(N < 0xffff), std::uint16_t, std::uint32_t>::type>::type;
+
+        static constexpr bool linear = N <= 16;
+        static constexpr bool simd = linear && std::is_integral<Key>::value && sizeof(Key) == 4
+                                     && std::is_same<Equal, std::equal_to<Key> >::value;
+        static constexpr size_t n_keys = simd ? (N + 3) / 4 * 4 : N;  // whole SSE2 loads
+
+        static constexpr size_t bucket_bits() {
+            size_t bits = 0;
+            while ((size_t(1) << bits) < N) bits++;
+            return bits;
+        }
+        static constexpr size_t n_buckets = linear ? 1 : size_t(1) << bucket_bits();
+
+        Key keys[n_keys];
+        Value values[N];
+        link_t prev[N];
+        link_t next[N];
+        link_t chain[N];            // the next slot in the bucket, or on the free list
+        link_t buckets[n_buckets];
+        link_t oldest;
+        link_t newest;
+        link_t top;                 // slots [1, top] were ever used
+        link_t free_head;
+        std::uint32_t occupied;     // bit i - 1 for slot i, linear only
+        size_t count;
+
+        static size_t bucket_of(const Key &key) {
+            return static_cast<std::uint32_t>(static_cast<std::uint32_t>(Hash()(key)) * 2654435769u)
+                   >> (32 - bucket_bits());
+        }
+
+        link_t locate(const Key &key) const {
+            if constexpr (linear) {
+                std::uint32_t hit = 0;
+#ifdef SJTU_STATIC_LRU_SSE2
+                if constexpr (simd) {
+                    const __m128i needle = _mm_set1_epi32(static_cast<int>(key));
+                    for (size_t i = 0; i < n_keys; i += 4) {
+                        __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(keys + i)), needle);
+                        hit |= static_cast<std::uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(eq))) << i;
+                    }
+                } else
+#endif
+                {
+                    for (size_t i = 0; i < N; i++) hit |= std::uint32_t(Equal()(keys[i], key)) << i;
+                }
+                hit &= occupied;
+                if (!hit) return 0;
+#if defined(__GNUC__)
+                return static_cast<link_t>(__builtin_ctz(hit) + 1);
+#else
+                link_t i = 1;
+                while (!(hit & 1)) {
+                    hit >>= 1;
+                    i++;
+                }
+                return i;
+#endif
+            } else {
+                for (link_t i = buckets[bucket_of(key)]; i; i = chain[i - 1]) {
+                    if (Equal()(keys[i - 1], key)) return i;
+                }
+                return 0;
+            }
+        }
+
+        void chain_in(link_t i) {
+            if constexpr (linear) {
+                occupied |= std::uint32_t(1) << (i - 1);
+            } else {
+                link_t &head = buckets[bucket_of(keys[i - 1])];
+                chain[i - 1] = head;
+                head = i;
+            }
+        }
+        void chain_out(link_t i) {
+            if constexpr (linear) {
+                occupied &= ~(std::uint32_t(1) << (i - 1));
+            } else {
+                link_t *link = &buckets[bucket_of(keys[i - 1])];
+                while (*link != i) link = &chain[*link - 1];
+                *link = chain[i - 1];
+            }
+        }
+
+        void unlink(link_t i) {
+            if (prev[i - 1]) next[prev[i - 1] - 1] = next[i - 1];
+            else oldest = next[i - 1];
+            if (next[i - 1]) prev[next[i - 1] - 1] = prev[i - 1];
+            else newest = prev[i - 1];
+        }
+        void link_newest(link_t i) {
+            prev[i - 1] = newest;
+            next[i - 1] = 0;
+            if (newest) next[newest - 1] = i;
+            else oldest = i;
+            newest = i;
+        }
+
+    public:
+        constexpr static_lru()
+            : keys(), values(), prev(), next(), chain(), buckets(),
+              oldest(0), newest(0), top(0), free_head(0), occupied(0), count(0) {}
+
+        static constexpr size_t capacity() {
+            return N;
+        }
+        constexpr size_t size() const {
+            return count;
+        }
+        constexpr bool empty() const {
+            return count == 0;
+        }
+
+        /**
+         * save the value connected with key as the newest one,
+         * the oldest value_pair makes room if the cache is full
+         */
+        void save(const Key &key, const Value &value) {
+            link_t i = locate(key);
+            if (i) {
+                values[i - 1] = value;
+                unlink(i);
+                link_newest(i);
+                return;
+            }
+            if (count == N) {
+                i = oldest;
+                chain_out(i);
+                unlink(i);
+            } else {
+                if (free_head) {
+                    i = free_head;
+                    free_head = chain[i - 1];
+                } else {
+                    i = ++top;
+                }
+                count++;
+            }
+            keys[i - 1] = key;
+            values[i - 1] = value;
+            chain_in(i);
+            link_newest(i);
+        }
+        void save(const pair<const Key, Value> &v) {
+            save(v.first, v.second);
+        }
+
+        /**
+         * return a pointer to the value and make it the newest,
+         * if the key not found, throw
+         */
+        Value *get(const Key &key) {
+            Value *value = find(key);
+            if (!value) {
+                throw index_out_of_bound();
+            }
+            return value;
+        }
+        /**
+         * like get(), but return nullptr on a miss
+         */
+        Value *find(const Key &key) {
+            link_t i = locate(key);
+            if (!i) return nullptr;
+            unlink(i);
+            link_newest(i);
+            return &values[i - 1];
+        }
+        /**
+         * whether key is cached, the order is untouched
+         */
+        bool contains(const Key &key) const {
+            return locate(key) != 0;
+        }
+
+        /**
+         * the value_pair exists, remove and return true
+         * otherwise, return false
+         */
+        bool remove(const Key &key) {
+            link_t i = locate(key);
+            if (!i) return false;
+            chain_out(i);
+            unlink(i);
+            values[i - 1] = Value();
+            chain[i - 1] = free_head;
+            free_head = i;
+            count--;
+            return true;
+        }
+
+        void clear() {
+            for (link_t i = oldest; i; i = next[i - 1]) values[i - 1] = Value();
+            for (size_t b = 0; b < n_buckets; b++) buckets[b] = 0;
+            oldest = newest = top = free_head = 0;
+            occupied = 0;
+            count = 0;
+        }
+
+        /**
+         * call fn(key, value) for every value_pair, oldest first
+         */
+        template <class Fn>
+        void for_each(Fn fn) const {
+            for (link_t i = oldest; i; i = next[i - 1]) fn(keys[i - 1], values[i - 1]);
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,200 @@
+#ifndef SJTU_THREAD_POOL_HPP
+#define SJTU_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace sjtu {
+    /**
+     * a work-stealing thread pool.
+     * every worker owns a deque: it pushes and pops its own tasks at the
+     * back, and when it runs dry it steals from the front of the others.
+     * a thread waiting on a parallel_for() runs tasks instead of blocking,
+     * so nested parallel_for() calls on the same pool never deadlock.
+     */
+    class thread_pool {
+        struct task {
+            virtual ~task() {}
+            virtual void run() = 0;
+        };
+        template <class Fn>
+        struct task_impl : task {
+            Fn fn;
+            explicit task_impl(Fn &&fn) : fn(std::move(fn)) {}
+            void run() override {
+                fn();
+            }
+        };
+        struct queue {
+            std::mutex lock;
+            std::deque<task *> tasks;
+        };
+
+        std::vector<std::thread> workers;
+        std::unique_ptr<queue[]> queues;
+        size_t n_queues;
+        std::atomic<size_t> pending;
+        std::atomic<size_t> next_queue;
+        std::mutex sleep_lock;
+        std::condition_variable wake;
+        bool stopping;
+
+        /**
+         * the pool the calling thread works for and its queue index
+         */
+        static thread_pool *&current() {
+            static thread_local thread_pool *pool = nullptr;
+            return pool;
+        }
+        static size_t &current_index() {
+            static thread_local size_t index = 0;
+            return index;
+        }
+
+        void push(task *t) {
+            size_t index = current() == this ? current_index() : next_queue++ % n_queues;
+            pending++;
+            {
+                std::lock_guard<std::mutex> guard(queues[index].lock);
+                queues[index].tasks.push_back(t);
+            }
+            std::lock_guard<std::mutex> guard(sleep_lock);
+            wake.notify_one();
+        }
+
+        task *pop(size_t home) {
+            {
+                std::lock_guard<std::mutex> guard(queues[home].lock);
+                if (!queues[home].tasks.empty()) {
+                    task *t = queues[home].tasks.back();
+                    queues[home].tasks.pop_back();
+                    return t;
+                }
+            }
+            for (size_t i = 1; i < n_queues; i++) {
+                queue &victim = queues[(home + i) % n_queues];
+                std::lock_guard<std::mutex> guard(victim.lock);
+                if (!victim.tasks.empty()) {
+                    task *t = victim.tasks.front();
+                    victim.tasks.pop_front();
+                    return t;
+                }
+            }
+            return nullptr;
+        }
+
+        void work(size_t index) {
+            current() = this;
+            current_index() = index;
+            for (;;) {
+                if (run_one()) continue;
+                std::unique_lock<std::mutex> guard(sleep_lock);
+                wake.wait(guard, [this] { return stopping || pending > 0; });
+                if (stopping && pending == 0) return;
+            }
+        }
+
+    public:
+        /**
+         * start threads workers, at least one
+         */
+        explicit thread_pool(size_t threads = std::thread::hardware_concurrency())
+            : n_queues(threads ? threads : 1), pending(0), next_queue(0), stopping(false) {
+            queues.reset(new queue[n_queues]);
+            for (size_t i = 0; i < n_queues; i++) {
+                workers.emplace_back(&thread_pool::work, this, i);
+            }
+        }
+        thread_pool(const thread_pool &other) = delete;
+        thread_pool &operator=(const thread_pool &other) = delete;
+        /**
+         * finish every submitted task, then join the workers
+         */
+        ~thread_pool() {
+            {
+                std::lock_guard<std::mutex> guard(sleep_lock);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (auto &worker : workers) worker.join();
+        }
+
+        size_t size() const {
+            return workers.size();
+        }
+
+        /**
+         * run fn() on some worker later
+         */
+        template <class Fn>
+        void submit(Fn fn) {
+            push(new task_impl<Fn>(std::move(fn)));
+        }
+
+        /**
+         * run one queued task on the calling thread,
+         * return false if there was nothing to do
+         */
+        bool run_one() {
+            task *t = pop(current() == this ? current_index() : next_queue % n_queues);
+            if (!t) return false;
+            pending--;
+            t->run();
+            delete t;
+            return true;
+        }
+
+        /**
+         * call fn(lo, hi) over [begin, end) cut into chunks of at least grain,
+         * and return when every chunk is done. the calling thread takes part,
+         * the first exception thrown by a chunk is rethrown here.
+         */
+        template <class Fn>
+        void parallel_for(size_t begin, size_t end, size_t grain, const Fn &fn) {
+            if (begin >= end) return;
+            if (grain == 0) grain = 1;
+            size_t chunks = (end - begin + grain - 1) / grain;
+            size_t limit = 4 * (workers.size() + 1);
+            if (chunks > limit) {
+                chunks = limit;
+                grain = (end - begin + chunks - 1) / chunks;
+                chunks = (end - begin + grain - 1) / grain;
+            }
+            if (chunks == 1) {
+                fn(begin, end);
+                return;
+            }
+            std::atomic<size_t> remaining(chunks);
+            std::exception_ptr error;
+            std::mutex error_lock;
+            auto run_chunk = [&](size_t lo, size_t hi) {
+                try {
+                    fn(lo, hi);
+                } catch (...) {
+                    std::lock_guard<std::mutex> guard(error_lock);
+                    if (!error) error = std::current_exception();
+                }
+                remaining--;
+            };
+            for (size_t lo = begin + grain; lo < end; lo += grain) {
+                size_t hi = lo + grain < end ? lo + grain : end;
+                submit([&run_chunk, lo, hi] { run_chunk(lo, hi); });
+            }
+            run_chunk(begin, begin + grain < end ? begin + grain : end);
+            while (remaining > 0) {
+                if (!run_one()) std::this_thread::yield();
+            }
+            if (error) std::rethrow_exception(error);
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,64 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+template<typename T>
+Matrix<T> reference_product(const Matrix<T> &a, const Matrix<T> &b){
+    Matrix<T> res(a.RowSize(), b.ColSize(), 0);
+    for(size_t i=0;i<a.RowSize();i++)
+        for(size_t j=0;j<b.ColSize();j++)
+            for(size_t k=0;k<a.ColSize();k++)
+                res[i][j] += a[i][k] * b[k][j];
+    return res;
+}
+
+template<typename T>
+Matrix<T> sample(size_t rows, size_t cols, int seed){
+    Matrix<T> res(rows, cols);
+    for(size_t i=0;i<rows;i++)
+        for(size_t j=0;j<cols;j++)
+            res[i][j] = static_cast<T>((seed * 131 + i * 31 + j * 17) % 201) - 100;
+    return res;
+}
+
+void matrix_product_tester(){
+    const size_t shapes[][3]={{1,1,1},{2,2,2},{3,5,7},{33,17,65},{64,64,64},{100,37,300},{129,257,131}};
+    int seed = 0;
+    for(auto &s : shapes){
+        Matrix<int> a = sample<int>(s[0], s[1], ++seed), b = sample<int>(s[1], s[2], ++seed);
+        Matrix<int> expect = reference_product(a, b);
+        if(!(a * b == expect) || !(MultiplyTransposed(a, Transpose(b)) == expect)){
+            std::cout<<c[1]<<std::endl;
+            exit(0);
+        }
+        Matrix<double> fa = sample<double>(s[0], s[1], ++seed), fb = sample<double>(s[1], s[2], ++seed);
+        if(!(fa * fb == reference_product(fa, fb))){
+            std::cout<<c[1]<<std::endl;
+            exit(0);
+        }
+        long long sum = 0;
+        for(size_t i=0;i<expect.RowSize();i++)
+            for(size_t j=0;j<expect.ColSize();j++)
+                sum += expect[i][j];
+        std::cout<<s[0]<<"x"<<s[1]<<"x"<<s[2]<<" "<<sum<<std::endl;
+    }
+    size_t e = 3;
+    std::cout<<Pow(sample<long long>(3, 3, 7), e);
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("10.out","w",stdout);
+#endif
+    matrix_product_tester();
+    std::cout << c[2] << std::endl;
+}
@@ -0,0 +1,92 @@
+#include "src.hpp"
+#include "eviction-queue.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+const char *cause_name(sjtu::eviction_cause cause){
+    switch(cause){
+        case sjtu::eviction_cause::size: return "size";
+        case sjtu::eviction_cause::expiry: return "expiry";
+        case sjtu::eviction_cause::removed: return "removed";
+        default: return "replaced";
+    }
+}
+
+// the snapshot goes to the temporary directory, not the working one
+std::string temp_path(const char *name){
+    const char *dir = std::getenv("TMPDIR");
+    return std::string(dir && *dir ? dir : "/tmp") + "/" + name;
+}
+
+class printer : public sjtu::eviction_listener {
+public:
+    int batches = 0;
+    void on_evict(sjtu::eviction *batch, size_t n) override {
+        batches++;
+        std::cout << "batch of " << n << std::endl;
+        for(size_t i=0;i<n;i++){
+            std::cout << batch[i].key << " " << cause_name(batch[i].cause) << " " << batch[i].value << std::endl;
+        }
+    }
+};
+
+void eviction_listener_tester(){
+    using value_type = sjtu::pair<Integer,Matrix<int> >;
+    printer inline_printer;
+    {
+        sjtu::lru tester(5);
+        tester.listen(&inline_printer, 4);
+        for(int i=0;i<12;i++){
+            tester.save(value_type(Integer(i),Matrix<int>(1,2,i)));
+        }
+        tester.save(value_type(Integer(9),Matrix<int>(1,2,-9)));
+        std::cout << (tester.remove(Integer(10)) ? c[0] : c[1]) << std::endl;
+        std::cout << (tester.remove(Integer(10)) ? c[1] : c[0]) << std::endl;
+        tester.flush_evictions();
+        tester.print();
+
+        // the entries a snapshot replaces leave as removed
+        const std::string path = temp_path("sjtu-lru-11.snapshot");
+        tester.save_snapshot(path.c_str());
+        sjtu::lru reloaded(5);
+        reloaded.listen(&inline_printer, 8);
+        reloaded.save(value_type(Integer(100),Matrix<int>(1,1,100)));
+        reloaded.save(value_type(Integer(101),Matrix<int>(1,1,101)));
+        reloaded.load_snapshot(path.c_str());
+        std::remove(path.c_str());
+        reloaded.flush_evictions();
+        std::cout << (reloaded.map.size() == 4 ? c[0] : c[1]) << std::endl;
+    }
+
+    printer background_printer;
+    {
+        sjtu::async_eviction_listener queue(background_printer);
+        sjtu::lru tester(3);
+        tester.listen(&queue, 2);
+        for(int i=0;i<8;i++){
+            tester.save(value_type(Integer(i),Matrix<int>(2,1,i)));
+        }
+        tester.flush_evictions();
+        queue.drain();
+        std::cout << "background batches " << background_printer.batches << std::endl;
+    }
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("11.out","w",stdout);
+#endif
+    eviction_listener_tester();
+    std::cout << c[2] << std::endl;
+}
@@ -0,0 +1,105 @@
+#include "src.hpp"
+#include "robin-hood.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cstdio>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+typedef sjtu::linked_hashmap<Integer,int,Hash,Equal> chained;
+typedef sjtu::linked_robin_hashmap<Integer,int,Hash,Equal> robin;
+
+void check(bool ok){
+    if(!ok){
+        std::cout<<c[1]<<std::endl;
+        exit(0);
+    }
+}
+
+bool same_order(chained &a, robin &b){
+    if(a.size() != b.size()) return false;
+    auto jt = b.begin();
+    for(auto it = a.begin(); it != a.end(); ++it, ++jt){
+        if(jt == b.end() || (*it).first.val != (*jt).first.val || (*it).second != (*jt).second) return false;
+    }
+    return jt == b.end();
+}
+
+void robin_hashmap_tester(){
+    chained a;
+    robin b;
+    unsigned seed = 12345;
+    auto next = [&seed](){ seed = seed * 1103515245u + 12345u; return (seed >> 8) % 4096; };
+    // an lru-like mix: every insertion past 1000 entries evicts the oldest one
+    for(int round = 0; round < 200000; round++){
+        int key = next(), op = next() % 8;
+        if(op < 4){
+            check(a.insert(sjtu::pair<const Integer,int>(Integer(key), round)).second
+                  == b.insert(sjtu::pair<const Integer,int>(Integer(key), round)).second);
+            if(a.size() > 1000){
+                a.remove(a.begin());
+                b.remove(b.begin());
+            }
+        }else if(op < 6){
+            auto it = a.find(Integer(key));
+            auto jt = b.find(key);
+            check((it == a.end()) == (jt == b.end()));
+            if(it != a.end()){
+                a.touch(it);
+                b.touch(jt);
+            }
+        }else if(op < 7){
+            auto it = a.find(Integer(key));
+            auto jt = b.find(Integer(key));
+            check((it == a.end()) == (jt == b.end()));
+            if(it != a.end()){
+                a.remove(it);
+                b.remove(jt);
+            }
+        }else{
+            check(a.count(Integer(key)) == b.count(key));
+        }
+    }
+    check(same_order(a, b));
+    std::cout<<"size "<<b.size()<<" longest probe "<<(b.index.max_distance() < 32 ? "short" : "long")<<std::endl;
+
+    robin copy(b);
+    check(same_order(a, copy));
+    // a moved-from map is empty and still usable
+    robin moved(std::move(copy));
+    check(same_order(a, moved) && copy.empty() && copy.find(Integer(1)) == copy.end());
+    copy.insert(sjtu::pair<const Integer,int>(Integer(1), 1));
+    check(copy.size() == 1 && copy.at(Integer(1)) == 1);
+    moved = std::move(copy);
+    check(moved.size() == 1 && copy.size() == a.size());
+    b.clear();
+    check(b.empty() && b.find(Integer(1)) == b.end());
+    bool thrown = false;
+    try{ b.at(Integer(1)); }catch(sjtu::index_out_of_bound &){ thrown = true; }
+    check(thrown);
+
+    // a nearly full table, then every key leaves again
+    robin dense(0, 0.9);
+    for(int i = 0; i < 900; i++) dense.insert(sjtu::pair<const Integer,int>(Integer(i * 7), i));
+    for(int i = 0; i < 900; i++) check(dense.at(Integer(i * 7)) == i && !dense.count(Integer(i * 7 + 1)));
+    for(int i = 0; i < 900; i += 2) dense.remove(dense.find(Integer(i * 7)));
+    for(int i = 0; i < 900; i++) check(dense.count(Integer(i * 7)) == size_t(i % 2));
+    int n = 0;
+    for(auto it = dense.begin(); it != dense.end(); ++it, ++n) if(n < 5) std::cout<<(*it).first.val<<" "<<(*it).second<<std::endl;
+    std::cout<<n<<" left"<<std::endl;
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("12.out","w",stdout);
+#endif
+    robin_hashmap_tester();
+    std::cout << c[2] << std::endl;
+}
@@ -0,0 +1,84 @@
+#include "src.hpp"
+#include "static-lru.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cstdio>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void check(bool ok){
+    if(!ok){
+        std::cout<<c[1]<<std::endl;
+        exit(0);
+    }
+}
+
+constexpr sjtu::static_lru<int,int,8> empty_cache;
+static_assert(empty_cache.size() == 0 && empty_cache.capacity() == 8, "constexpr construction");
+
+/**
+ * replay the same traffic on an lru and a static_lru of capacity N,
+ * they must keep the same value_pairs in the same order
+ */
+template<size_t N>
+void replay(int rounds, int keys){
+    using value_type = sjtu::pair<const Integer,Matrix<int> >;
+    sjtu::lru dynamic(N);
+    sjtu::static_lru<int,Matrix<int>,N> fixed;
+    unsigned seed = 2024 + N;
+    for(int round = 0; round < rounds; round++){
+        seed = seed * 1103515245u + 12345u;
+        int key = (seed >> 8) % keys, op = (seed >> 20) % 8;
+        if(op < 4){
+            dynamic.save(value_type(Integer(key), Matrix<int>(1, 2, round)));
+            fixed.save(key, Matrix<int>(1, 2, round));
+        }else if(op < 6){
+            Matrix<int> *value = fixed.find(key);
+            check((dynamic.map.find(key) == dynamic.map.end()) == (value == nullptr));
+            if(value) check(*dynamic.get(key) == *value);
+        }else if(op < 7){
+            check(dynamic.remove(Integer(key)) == fixed.remove(key));
+        }else{
+            check(dynamic.map.count(key) == size_t(fixed.contains(key)));
+        }
+    }
+    check(dynamic.map.size() == fixed.size());
+    auto it = dynamic.map.begin();
+    fixed.for_each([&](int key, const Matrix<int> &value){
+        check(it != dynamic.map.end() && (*it).first.val == key && (*it).second == value);
+        ++it;
+    });
+}
+
+void static_lru_tester(){
+    replay<8>(20000, 20);
+    replay<16>(20000, 40);
+    replay<200>(50000, 500);
+
+    sjtu::static_lru<int,int,4> small;
+    for(int i = 0; i < 6; i++) small.save(i, i * i);
+    small.get(3);
+    small.save(9, 81);
+    bool thrown = false;
+    try{ small.get(2); }catch(sjtu::index_out_of_bound &){ thrown = true; }
+    check(thrown);
+    small.for_each([](int key, int value){ std::cout<<key<<" "<<value<<std::endl; });
+    small.clear();
+    check(small.empty() && small.find(3) == nullptr);
+    std::cout<<sizeof(sjtu::static_lru<int,int,8>)<<" bytes for 8 entries"<<std::endl;
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("13.out","w",stdout);
+#endif
+    static_lru_tester();
+    std::cout << c[2] << std::endl;
+}
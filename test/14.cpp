@@ -0,0 +1,125 @@
+#include "src.hpp"
+#include "mapped-image.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+typedef sjtu::linked_hashmap<Integer,Matrix<int>,Hash,Equal> source;
+
+// the images go to the temporary directory, not the working one
+std::string temp_path(const char *name){
+    const char *dir = std::getenv("TMPDIR");
+    return std::string(dir && *dir ? dir : "/tmp") + "/" + name;
+}
+
+const std::string good = temp_path("sjtu-lru-14.image");
+const std::string bad = temp_path("sjtu-lru-14.bad");
+
+void check(bool ok){
+    if(!ok){
+        std::cout<<c[1]<<std::endl;
+        std::remove(good.c_str());
+        std::remove(bad.c_str());
+        exit(0);
+    }
+}
+
+std::vector<char> read_file(const std::string &path){
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+std::uint64_t load64(const std::vector<char> &bytes, size_t offset){
+    std::uint64_t v;
+    std::memcpy(&v, bytes.data() + offset, sizeof(v));
+    return v;
+}
+
+// write bytes with the 64-bit word at offset replaced, then try to map it
+bool rejected(std::vector<char> bytes, size_t offset, std::uint64_t value){
+    std::memcpy(bytes.data() + offset, &value, sizeof(value));
+    {
+        std::ofstream out(bad, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), bytes.size());
+    }
+    try{
+        sjtu::mapped_image image(bad.c_str());
+    }catch(sjtu::runtime_error &){
+        return true;
+    }
+    return false;
+}
+
+void mapped_image_tester(){
+    source map;
+    const int n=300;
+    for(int i=0;i<n;i++){
+        map.insert(sjtu::pair<const Integer,Matrix<int> >(Integer(i*3),Matrix<int>(i%4+1,i%3+1,i)));
+    }
+    sjtu::mapped_image::build(map, good.c_str());
+
+    {
+        sjtu::mapped_image image(good.c_str());
+        check(image.size() == size_t(n));
+        for(int i=0;i<n;i++){
+            sjtu::mapped_image::view v = image.at(Integer(i*3));
+            check(v.RowSize() == size_t(i%4+1) && v.ColSize() == size_t(i%3+1) && v[v.RowSize()-1][v.ColSize()-1] == i);
+            check(v.to_matrix() == map.at(Integer(i*3)));
+            check(!image.count(Integer(i*3+1)));
+        }
+        bool thrown = false;
+        try{ image.at(Integer(-1)); }catch(sjtu::index_out_of_bound &){ thrown = true; }
+        check(thrown);
+        sjtu::mapped_image::view v = image.at(Integer(30));
+        std::cout<<image.size()<<" entries, key 30 is "<<v.RowSize()<<"x"<<v.ColSize()<<" of "<<v[0][0]<<std::endl;
+    }
+
+    // header: magic, bucket_count @8, entry_count @16, file_size @24, then the bucket heads
+    // entry: key, hash, next @8, rows @16, cols @24, payload @32
+    std::vector<char> bytes = read_file(good);
+    const size_t buckets = 32;
+    const size_t first_entry = buckets + load64(bytes, 8) * 8;
+    check(!rejected(bytes, 0, load64(bytes, 0)));                      // a faithful copy maps
+    check(rejected(bytes, 0, 0));                                       // magic
+    check(rejected(bytes, 8, 0));                                       // no buckets
+    check(rejected(bytes, 8, 48));                                      // not a power of two
+    check(rejected(bytes, 8, std::uint64_t(1) << 62));                  // bucket_count * 8 overflows
+    check(rejected(bytes, 16, std::uint64_t(1) << 61));                 // entry_count * 40 wraps
+    check(rejected(bytes, 16, load64(bytes, 16) + 1000));               // more entries than fit
+    check(rejected(bytes, 24, bytes.size() + 64));                      // file_size
+    check(rejected(bytes, buckets, bytes.size() + 8));                  // a head past the end
+    check(rejected(bytes, buckets, first_entry + 4));                   // a head inside an entry
+    check(rejected(bytes, first_entry + 8, 8));                         // next into the header
+    check(rejected(bytes, first_entry + 32, bytes.size() + 4096));      // payload past the end
+    check(rejected(bytes, first_entry + 11 * 40 + 32, bytes.size() - 4)); // a 4x3 payload running over the end
+    check(rejected(bytes, first_entry + 16, std::uint64_t(1) << 62));   // rows * cols overflows
+    std::cout<<"corrupted images rejected"<<std::endl;
+
+    // a truncated copy no longer matches its header
+    bytes.resize(bytes.size() - 64);
+    check(rejected(bytes, 0, load64(bytes, 0)));
+    std::remove(good.c_str());
+    std::remove(bad.c_str());
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("14.out","w",stdout);
+#endif
+    mapped_image_tester();
+    std::cout << c[2] << std::endl;
+}
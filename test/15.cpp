@@ -0,0 +1,106 @@
+#include "src.hpp"
+#include "concurrent-hashmap.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cstdio>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+typedef sjtu::pair<const Integer,Matrix<int> > value_type;
+typedef sjtu::linked_hashmap<Integer,Matrix<int>,Hash,Equal> chained;
+typedef sjtu::concurrent_hashmap<Integer,Matrix<int>,Hash,Equal> concurrent;
+
+void check(bool ok){
+    if(!ok){
+        std::cout<<c[1]<<std::endl;
+        exit(0);
+    }
+}
+
+bool same_order(chained &a, concurrent &b){
+    if(a.size() != b.size()) return false;
+    bool same = true;
+    auto it = a.begin();
+    b.for_each([&](const value_type &v){
+        if(it == a.end() || (*it).first.val != v.first.val || !((*it).second == v.second)) same = false;
+        else ++it;
+    });
+    return same && it == a.end();
+}
+
+void concurrent_hashmap_tester(){
+    chained a;
+    concurrent b;
+    unsigned seed = 2024;
+    auto next = [&seed](){ seed = seed * 1103515245u + 12345u; return (seed >> 8) % 3000; };
+    // the same lru-like mix on both maps, single-threaded
+    for(int round = 0; round < 60000; round++){
+        int key = next(), op = next() % 8;
+        if(op < 4){
+            value_type v(Integer(key), Matrix<int>(1, key % 3 + 1, round));
+            auto it = a.find(Integer(key));
+            bool fresh = it == a.end();
+            if(!fresh) a.remove(it);
+            a.insert(v);
+            check(b.insert(v) == fresh);
+            if(a.size() > 1500){
+                a.remove(a.begin());
+                check(b.remove_oldest());
+            }
+        }else if(op < 6){
+            auto it = a.find(Integer(key));
+            Matrix<int> out;
+            check(b.find(Integer(key), out) == (it != a.end()));
+            if(it != a.end()){
+                check(out == (*it).second);
+                a.touch(it);
+                check(b.touch(Integer(key)));
+            }else{
+                check(!b.touch(Integer(key)));
+            }
+        }else if(op < 7){
+            auto it = a.find(Integer(key));
+            if(it != a.end()) a.remove(it);
+            check(b.remove(Integer(key)) == (it != a.end()));
+        }else{
+            check(b.count(key) == a.count(Integer(key)));
+        }
+    }
+    check(same_order(a, b));
+    std::cout<<"size "<<b.size()<<std::endl;
+
+    int seen = -1;
+    check(b.visit(Integer((*a.begin()).first.val), [&seen](const value_type &v){ seen = v.second[0][0]; }));
+    check(seen == (*a.begin()).second[0][0]);
+    check(!b.visit(Integer(-1), [&seen](const value_type &){ seen = -1; }) && seen != -1);
+
+    b.clear();
+    check(b.empty() && !b.count(Integer(1)) && !b.remove_oldest());
+    // growing from empty keeps the insertion order
+    for(int i = 0; i < 5000; i++) check(b.insert(value_type(Integer(i * 5), Matrix<int>(2, 2, i))));
+    check(b.size() == 5000 && !b.insert(value_type(Integer(0), Matrix<int>(1, 1, -1))));
+    int n = 0;
+    b.for_each([&n](const value_type &v){
+        if(n < 3 || n == 4999) std::cout<<v.first.val<<" "<<v.second.RowSize()<<"x"<<v.second.ColSize()<<" "<<v.second[0][0]<<std::endl;
+        n++;
+    });
+    for(int i = 0; i < 4000; i++) check(b.remove_oldest());
+    Matrix<int> out;
+    check(!b.find(Integer(5), out) && b.find(Integer(0), out) && out[0][0] == -1);
+    std::cout<<b.size()<<" left"<<std::endl;
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("15.out","w",stdout);
+#endif
+    concurrent_hashmap_tester();
+    std::cout << c[2] << std::endl;
+}
@@ -0,0 +1,82 @@
+#include "src.hpp"
+#include "front-cache.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cstdio>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+typedef sjtu::pair<Integer,Matrix<int> > value_type;
+
+void check(bool ok){
+    if(!ok){
+        std::cout<<c[1]<<std::endl;
+        exit(0);
+    }
+}
+
+bool missing(sjtu::front_cache<> &front, int key){
+    try{ front.get(key); }catch(sjtu::index_out_of_bound &){ return true; }
+    return false;
+}
+
+void front_cache_tester(){
+    std::mutex lock;
+    sjtu::lru shared(100);
+    for(int i=0;i<100;i++) shared.save(value_type(Integer(i),Matrix<int>(1,2,i)));
+
+    sjtu::front_cache<> front(shared, lock, 8);
+    for(int round=0;round<3;round++){
+        for(int i=0;i<100;i++) check((*front.get(i))[0][1] == i);
+    }
+    check((*front.get(Integer(42)))[0][0] == 42);
+
+    // a save, a write through the lru and an eviction are all seen
+    shared.save(value_type(Integer(5),Matrix<int>(2,2,55)));
+    check(front.get(5)->RowSize() == 2 && (*front.get(5))[1][1] == 55);
+    (*shared.get(Integer(6)))[0][0] = 66;
+    check((*front.get(6))[0][0] == 66);
+    check(missing(front, 1000));
+    for(int i=100;i<300;i++) shared.save(value_type(Integer(i),Matrix<int>(1,1,i)));
+    check(missing(front, 3) && missing(front, 5));
+    for(int i=200;i<300;i++) check((*front.get(i))[0][0] == i);
+
+    // hits stay out of the lru order unless they are every refresh-th one
+    for(int refresh : {1000, 2}){
+        sjtu::lru small(3);
+        sjtu::front_cache<> hot(small, lock, refresh);
+        small.save(value_type(Integer(1),Matrix<int>(1,1,1)));
+        check((*hot.get(1))[0][0] == 1);
+        small.save(value_type(Integer(2),Matrix<int>(1,1,2)));
+        small.save(value_type(Integer(3),Matrix<int>(1,1,3)));
+        check((*hot.get(1))[0][0] == 1);
+        check((*hot.get(1))[0][0] == 1);
+        small.save(value_type(Integer(4),Matrix<int>(1,1,4)));
+        std::cout<<"refresh "<<refresh<<": key 1 "<<(missing(hot, 1) ? "evicted" : "kept")
+                 <<", key 2 "<<(missing(hot, 2) ? "evicted" : "kept")<<std::endl;
+    }
+
+    // more hot keys than ways in one set
+    sjtu::front_cache<1, 2> narrow(shared, lock);
+    for(int round=0;round<10;round++){
+        for(int i=200;i<205;i++) check((*narrow.get(i))[0][0] == i);
+    }
+    front.clear();
+    check((*front.get(250))[0][0] == 250);
+    std::cout<<"newest "<<(*front.get(299))[0][0]<<", size "<<shared.map.size()<<std::endl;
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("16.out","w",stdout);
+#endif
+    front_cache_tester();
+    std::cout << c[2] << std::endl;
+}
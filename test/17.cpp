@@ -0,0 +1,120 @@
+#include "src.hpp"
+#include "spill-tier.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <dirent.h>
+#include <unistd.h>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+typedef sjtu::pair<Integer,Matrix<int> > value_type;
+
+std::string dir;   // a fresh temporary directory for the segments
+
+int files(bool remove = false){
+    int n = 0;
+    DIR *d = opendir(dir.c_str());
+    while(dirent *e = readdir(d)){
+        if(e->d_name[0] == '.') continue;
+        if(remove) unlink((dir + "/" + e->d_name).c_str());
+        n++;
+    }
+    closedir(d);
+    return n;
+}
+
+void check(bool ok){
+    if(!ok){
+        std::cout<<c[1]<<std::endl;
+        if(!dir.empty()){
+            files(true);
+            rmdir(dir.c_str());
+        }
+        exit(0);
+    }
+}
+
+int loads = 0;
+bool loader(const Integer &key, Matrix<int> &value){
+    if(key.val < 0) return false;
+    loads++;
+    value = Matrix<int>(3, 3, key.val);
+    return true;
+}
+
+void spill_tier_tester(){
+    const char *tmp = std::getenv("TMPDIR");
+    std::string pattern = std::string(tmp && *tmp ? tmp : "/tmp") + "/sjtu-lru-17.XXXXXX";
+    if(mkdtemp(&pattern[0]) == nullptr) check(false);
+    dir = pattern;
+    std::string snapshot = dir + "/17.snapshot";
+    {
+        sjtu::spill_tier tier(dir, 64 << 10, 8 << 10, 1 << 10);
+        sjtu::lru cache(10);
+        cache.attach(&tier);
+        for(int i=0;i<100;i++) check((*cache.get_or_load(Integer(i), loader))[2][2] == i);
+        check(loads == 100 && tier.size() == 90);
+        // the evicted values come back from the tier, not the loader
+        for(int i=0;i<100;i++) check((*cache.get_or_load(Integer(i), loader))[1][1] == i);
+        check(loads == 100 && tier.size() == 90);
+        std::cout<<"spilled "<<tier.size()<<", "<<files()<<" segments"<<std::endl;
+
+        // a saved value hides its spilled copy
+        cache.save(value_type(Integer(3), Matrix<int>(1, 1, -3)));
+        for(int i=200;i<220;i++) cache.get_or_load(Integer(i), loader);
+        check((*cache.get_or_load(Integer(3), loader))[0][0] == -3 && loads == 120);
+
+        // a cleared lru forgets what it spilled
+        cache.clear();
+        check(tier.size() == 0 && tier.bytes() == 0 && files() == 0);
+        check((*cache.get_or_load(Integer(3), loader))[0][0] == 3 && loads == 121);
+        for(int i=0;i<10;i++) cache.get_or_load(Integer(i), loader);
+        cache.save_snapshot(snapshot.c_str());
+        for(int i=300;i<350;i++) cache.get_or_load(Integer(i), loader);
+        check(tier.size() > 0);
+
+        // and so does one that is reloaded
+        loads = 0;
+        cache.load_snapshot(snapshot.c_str());
+        check(tier.size() == 0);
+        for(int i=0;i<10;i++) check((*cache.get_or_load(Integer(i), loader))[0][0] == i);
+        check(loads == 0);
+        check((*cache.get_or_load(Integer(300), loader))[0][0] == 300 && loads == 1);
+        std::remove(snapshot.c_str());
+
+        // on its own: take moves a value out, erase drops it, the budget holds
+        Matrix<int> out;
+        tier.clear();
+        tier.put(Integer(7), Matrix<int>(2, 5, 7));
+        check(tier.take(Integer(7), out) && out.RowSize() == 2 && out[1][4] == 7);
+        check(!tier.take(Integer(7), out));
+        tier.put(Integer(8), Matrix<int>(1, 1, 8));
+        tier.erase(Integer(8));
+        check(!tier.take(Integer(8), out));
+        for(int i=0;i<2000;i++) tier.put(Integer(i), Matrix<int>(4, 4, i));
+        tier.flush();
+        check(tier.bytes() <= (64 << 10) + (8 << 10) && tier.size() < 2000);
+        check(tier.take(Integer(1999), out) && out[3][3] == 1999);
+        std::cout<<"budget kept, newest "<<out[0][0]<<std::endl;
+    }
+    check(files() == 0);
+    rmdir(dir.c_str());
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("17.out","w",stdout);
+#endif
+    spill_tier_tester();
+    std::cout << c[2] << std::endl;
+}
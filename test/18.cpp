@@ -0,0 +1,82 @@
+#include "src.hpp"
+#include "int-codec.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cstdio>
+#include <climits>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void check(bool ok){
+    if(!ok){
+        std::cout<<c[1]<<std::endl;
+        exit(0);
+    }
+}
+
+unsigned seed = 7;
+unsigned next(){
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 1;
+}
+
+// encode after a marker word, decode into a buffer with a guard value at the end
+size_t round_trip(const std::vector<int> &values){
+    std::vector<std::uint32_t> out(1, 0xdeadbeefu);
+    int_codec::Encode(values.data(), values.size(), out);
+    check(out[0] == 0xdeadbeefu && int_codec::Count(out.data() + 1) == values.size());
+    std::vector<int> back(values.size() + 1, 42);
+    int_codec::Decode(out.data() + 1, back.data());
+    check(back[values.size()] == 42);
+    for(size_t i = 0; i < values.size(); i++) check(back[i] == values[i]);
+    return out.size() - 1;
+}
+
+void int_codec_tester(){
+    for(int t = 0; t < 2000; t++){
+        size_t n = next() % 700;
+        int range = 1 << (next() % 31);
+        std::vector<int> values(n);
+        for(size_t i = 0; i < n; i++){
+            switch(t % 5){
+                case 0: values[i] = static_cast<int>(next() * 2u + (next() & 1)); break;
+                case 1: values[i] = -7; break;
+                case 2: values[i] = static_cast<int>(i * 3) + static_cast<int>(next() % range); break;
+                case 3: values[i] = i % 2 ? INT_MIN : INT_MAX; break;
+                default: values[i] = static_cast<int>(n - i) - static_cast<int>(next() % 4); break;
+            }
+        }
+        round_trip(values);
+    }
+
+    // the size of the encoding follows the range of the deltas
+    std::vector<int> constant(1000, 123456), ramp(1000), noisy(1000);
+    for(int i = 0; i < 1000; i++){
+        ramp[i] = 5000 - i * 2;
+        noisy[i] = static_cast<int>(next());
+    }
+    std::cout<<"empty "<<round_trip(std::vector<int>())<<" words"<<std::endl;
+    std::cout<<"constant "<<round_trip(constant)<<" words"<<std::endl;
+    std::cout<<"ramp "<<round_trip(ramp)<<" words"<<std::endl;
+    std::cout<<"noisy "<<round_trip(noisy)<<" words"<<std::endl;
+    std::cout<<"one "<<round_trip(std::vector<int>(1, -1))<<" words"<<std::endl;
+    std::cout<<"zigzag "<<int_codec::ZigZag(static_cast<std::uint32_t>(-3))<<" "<<static_cast<int>(int_codec::UnZigZag(5))
+             <<" width "<<int_codec::BitWidth(0)<<" "<<int_codec::BitWidth(0x80000000u)<<std::endl;
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("18.out","w",stdout);
+#endif
+    int_codec_tester();
+    std::cout << c[2] << std::endl;
+}
@@ -0,0 +1,100 @@
+#include "src.hpp"
+#include "reclaimer.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+typedef sjtu::pair<Integer,Matrix<int> > value_type;
+
+void check(bool ok){
+    if(!ok){
+        std::cout<<c[1]<<std::endl;
+        exit(0);
+    }
+}
+
+// keeps what it is given, to see which values arrive and in what batches
+class collector : public sjtu::value_reclaimer {
+public:
+    std::vector<int> batches;
+    std::vector<Matrix<int> > values;
+    void retire(std::vector<Matrix<int> > &retired) override {
+        batches.push_back(static_cast<int>(retired.size()));
+        for(auto &v : retired) values.push_back(std::move(v));
+        retired.clear();
+    }
+};
+
+void reclaimer_tester(){
+    // without a reclaimer the values wait for reclaim()
+    {
+        sjtu::lru tester(4);
+        tester.defer_destruction(true);
+        for(int i=0;i<10;i++) tester.save(value_type(Integer(i),Matrix<int>(20,20,i)));
+        check(tester.reclaim(0) == 6);
+        tester.save(value_type(Integer(9),Matrix<int>(1,1,-9)));
+        check(tester.reclaim(0) == 7);
+        check(tester.remove(Integer(8)) && tester.reclaim(2) == 6);
+        tester.clear();
+        check(tester.map.size() == 0 && tester.reclaim(0) == 9);
+        check(tester.reclaim() == 0);
+        tester.save(value_type(Integer(1),Matrix<int>(1,1,1)));
+        check((*tester.get(Integer(1)))[0][0] == 1);
+        tester.defer_destruction(false);
+        tester.save(value_type(Integer(1),Matrix<int>(1,1,2)));
+        check(tester.reclaim(0) == 0);
+        std::cout<<"deferred "<<c[0]<<std::endl;
+    }
+
+    // with one, they are handed over in batches, oldest first
+    {
+        collector sink;
+        sjtu::lru tester(8);
+        tester.defer_destruction(true, &sink);
+        for(int i=0;i<200;i++) tester.save(value_type(Integer(i),Matrix<int>(2,3,i)));
+        check(tester.reclaim(0) == 0);
+        tester.remove(Integer(199));
+        tester.clear();
+        tester.defer_destruction(false);
+        std::cout<<"batches";
+        for(int n : sink.batches) std::cout<<" "<<n;
+        std::cout<<std::endl;
+        check(sink.values.size() == 200);
+        for(int i=0;i<192;i++) check(sink.values[i].RowSize() == 2 && sink.values[i][1][2] == i);
+        check(sink.values[192][0][0] == 199);
+    }
+
+    // the background one frees them on its own thread, the lru is unaffected
+    {
+        sjtu::background_reclaimer background;
+        sjtu::lru tester(16);
+        tester.defer_destruction(true, &background);
+        Matrix<int> shared(64, 64, 7);
+        for(int i=0;i<1000;i++){
+            tester.save(value_type(Integer(i), i % 2 ? shared : Matrix<int>(64, 64, i)));
+            check((*tester.get(Integer(i)))[63][63] == (i % 2 ? 7 : i));
+        }
+        tester.clear();
+        check(tester.reclaim() == 0 && shared[0][0] == 7);
+        tester.defer_destruction(false);
+    }
+    std::cout<<"background "<<c[0]<<std::endl;
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("19.out","w",stdout);
+#endif
+    reclaimer_tester();
+    std::cout << c[2] << std::endl;
+}
@@ -0,0 +1,128 @@
+// needs C++20 coroutines, e.g. g++ -std=c++20
+#include "src.hpp"
+#include "async-lru.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cstdio>
+#include <atomic>
+#include <string>
+#include <thread>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void check(bool ok){
+    if(!ok){
+        std::cout<<c[1]<<std::endl;
+        exit(0);
+    }
+}
+
+// a coroutine that starts at once and is never awaited
+struct task {
+    struct promise_type {
+        task get_return_object(){ return {}; }
+        std::suspend_never initial_suspend(){ return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void(){}
+        void unhandled_exception(){ std::terminate(); }
+    };
+};
+
+std::atomic<int> done(0), loads(0);
+std::atomic<bool> release_load(false);
+
+enum outcome { pending, value, missing, failed };
+
+bool loader(const Integer &key, Matrix<int> &value){
+    loads++;
+    while(!release_load) std::this_thread::yield();
+    if(key.val < 0) return false;
+    if(key.val == 999) throw sjtu::runtime_error();
+    value = Matrix<int>(2, 2, key.val);
+    return true;
+}
+
+task lookup(sjtu::async_lru &async, int key, bool load, outcome &result, int &seen){
+    try{
+        Matrix<int> m;
+        if(load) m = co_await async.co_get_or_load(key, loader);
+        else m = co_await async.co_get(key);
+        seen = m[1][1];
+        result = value;
+    }catch(sjtu::index_out_of_bound &){
+        result = missing;
+    }catch(sjtu::runtime_error &){
+        result = failed;
+    }
+    done++;
+}
+
+void wait_for(int n){
+    while(done < n) std::this_thread::yield();
+}
+
+void async_lru_tester(){
+    const int before = Integer::counter;
+    {
+        sjtu::thread_pool pool(1);
+        sjtu::lru cache(100);
+        sjtu::async_lru async(cache, pool);
+        async.with([](sjtu::lru &l){ l.save(sjtu::pair<Integer,Matrix<int> >(Integer(1), Matrix<int>(2, 2, 1))); });
+
+        // a hit completes before co_await returns
+        outcome r[8] = {};
+        int seen[8] = {};
+        lookup(async, 1, false, r[0], seen[0]);
+        lookup(async, 1, true, r[1], seen[1]);
+        check(done == 2 && r[0] == value && r[1] == value && seen[0] == 1 && seen[1] == 1);
+        lookup(async, 2, false, r[2], seen[2]);
+        check(done == 3 && r[2] == missing);
+
+        // a miss loads once, everyone else waiting for the key joins it
+        lookup(async, 5, true, r[3], seen[3]);
+        lookup(async, 5, true, r[4], seen[4]);
+        lookup(async, 5, false, r[5], seen[5]);
+        check(done == 3 && r[3] == pending);
+        release_load = true;
+        wait_for(6);
+        check(loads == 1);
+        for(int i = 3; i < 6; i++) check(r[i] == value && seen[i] == 5);
+        check(async.with([](sjtu::lru &l){ return l.map.count(Integer(5)); }) == 1);
+
+        // nothing found, or the loader threw
+        lookup(async, -1, true, r[6], seen[6]);
+        lookup(async, 999, true, r[7], seen[7]);
+        wait_for(8);
+        check(r[6] == missing && r[7] == failed && loads == 3);
+        check(async.with([](sjtu::lru &l){ return l.map.size(); }) == 2);
+        std::cout<<"loads "<<loads<<", cached "<<async.with([](sjtu::lru &l){ return l.map.size(); })<<std::endl;
+
+        // many keys at once, while this thread makes keys of its own
+        const int n = 200;
+        outcome many[n] = {};
+        int got[n] = {};
+        for(int i = 0; i < n; i++) lookup(async, 100 + i % 50, true, many[i], got[i]);
+        while(done < 8 + n){
+            Integer key(done);
+            check(async.with([&key](sjtu::lru &l){ return l.map.count(key) <= 1; }));
+        }
+        for(int i = 0; i < n; i++) check(many[i] == value && got[i] == 100 + i % 50);
+        std::cout<<"loads "<<loads<<" for "<<n<<" lookups"<<std::endl;
+    }
+    // the keys made on the pool thread are all counted and gone again
+    check(Integer::counter == before);
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("20.out","w",stdout);
+#endif
+    async_lru_tester();
+    std::cout << c[2] << std::endl;
+}
@@ -0,0 +1,104 @@
+#include "src.hpp"
+#include "cuckoo-index.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cstdio>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void check(bool ok){
+    if(!ok){
+        std::cout<<c[1]<<std::endl;
+        exit(0);
+    }
+}
+
+// every value ever stored for key k is one of these two
+long value_of(int k, bool second){
+    return second ? -3L * k - 1 : 3L * k;
+}
+
+void cuckoo_stress_tester(){
+    const int threads = 32, per = 3000, shared = 2000;
+    sjtu::cuckoo_index<int, long> index(16);  // grows many times while everyone writes
+    std::atomic<int> bad(0);
+    std::vector<std::thread> workers;
+    for(int t = 0; t < threads; t++){
+        workers.emplace_back([&index, &bad, t](){
+            unsigned seed = t * 2654435761u + 1;
+            for(int i = 0; i < per; i++){
+                // keys of its own: insert, read back, remove every fourth one again
+                int k = shared + t * per + i;
+                if(!index.insert(k, value_of(k, false))) bad++;
+                long v;
+                if(!index.find(k, v) || v != value_of(k, false)) bad++;
+                if(i % 4 == 3){
+                    if(!index.remove(k - 1) || index.count(k - 1)) bad++;
+                }
+                // keys everyone fights over: any value seen must be a whole one
+                seed = seed * 1103515245u + 12345u;
+                int s = (seed >> 8) % shared;
+                switch((seed >> 4) % 4){
+                    case 0: index.insert(s, value_of(s, t % 2)); break;
+                    case 1: index.remove(s); break;
+                    default:
+                        if(index.find(s, v) && v != value_of(s, false) && v != value_of(s, true)) bad++;
+                }
+                // somebody else's key
+                int o = shared + (k * 7919) % (threads * per);
+                if(index.find(o, v) && v != value_of(o, false)) bad++;
+            }
+        });
+    }
+    for(auto &w : workers) w.join();
+    check(bad == 0);
+
+    size_t own = 0, contested = 0;
+    index.for_each([&](int k, long v){
+        if(k < shared){
+            contested++;
+            check(v == value_of(k, false) || v == value_of(k, true));
+        }else{
+            own++;
+            check((k - shared) % per % 4 != 2 && v == value_of(k, false));
+        }
+    });
+    check(own == size_t(threads) * (per - per / 4) && index.size() == own + contested);
+    std::cout<<threads<<" threads, "<<own<<" keys left"<<std::endl;
+
+    // single-threaded, it fills up well before the first grow
+    sjtu::cuckoo_index<int, int> dense(1 << 14);
+    size_t capacity = dense.capacity();
+    int n = 0;
+    while(dense.capacity() == capacity){
+        dense.insert(n, n + 1);
+        n++;
+    }
+    check(double(n - 1) / capacity > 0.9);
+    for(int i = 0; i < n; i++){
+        int v;
+        check(dense.find(i, v) && v == i + 1);
+    }
+    check(!dense.count(n) && dense.remove(0) && !dense.remove(0) && dense.size() == size_t(n - 1));
+    dense.clear();
+    check(dense.empty() && !dense.count(3));
+    std::cout<<"dense fill "<<c[0]<<std::endl;
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("21.out","w",stdout);
+#endif
+    cuckoo_stress_tester();
+    std::cout << c[2] << std::endl;
+}
@@ -0,0 +1,117 @@
+#include "src.hpp"
+#include "compact-hashmap.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cstdio>
+#include <string>
+#include <utility>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+typedef sjtu::pair<const Integer,Matrix<int> > value_type;
+typedef sjtu::linked_hashmap<Integer,Matrix<int>,Hash,Equal> chained;
+typedef sjtu::compact_linked_hashmap<Integer,Matrix<int>,Hash,Equal> compact;
+
+void check(bool ok){
+    if(!ok){
+        std::cout<<c[1]<<std::endl;
+        exit(0);
+    }
+}
+
+bool same_order(chained &a, compact &b){
+    if(a.size() != b.size()) return false;
+    auto jt = b.begin();
+    for(auto it = a.begin(); it != a.end(); ++it, ++jt){
+        if(jt == b.end() || (*it).first.val != (*jt).first.val || !((*it).second == (*jt).second)) return false;
+    }
+    return jt == b.end();
+}
+
+void compact_hashmap_tester(){
+    chained a;
+    compact b;
+    unsigned seed = 777;
+    auto next = [&seed](){ seed = seed * 1103515245u + 12345u; return (seed >> 8) % 3000; };
+    // an lru-like mix: every insertion past 700 entries evicts the oldest one
+    for(int round = 0; round < 100000; round++){
+        int key = next(), op = next() % 8;
+        if(op < 4){
+            value_type v(Integer(key), Matrix<int>(1, 2, round));
+            check(a.insert(v).second == b.insert(v).second);
+            if(a.size() > 700){
+                a.remove(a.begin());
+                b.remove(b.begin());
+            }
+        }else if(op < 6){
+            auto it = a.find(Integer(key));
+            auto jt = b.find(key);
+            check((it == a.end()) == (jt == b.end()));
+            if(it != a.end()){
+                check((*it).second == (*jt).second);
+                a.touch(it);
+                b.touch(jt);
+            }
+        }else if(op < 7){
+            auto it = a.find(Integer(key));
+            auto jt = b.find(Integer(key));
+            check((it == a.end()) == (jt == b.end()));
+            if(it != a.end()){
+                a.remove(it);
+                b.remove(jt);
+            }
+        }else{
+            check(a.count(Integer(key)) == b.count(key));
+        }
+    }
+    check(same_order(a, b));
+    auto newest = b.end();
+    --newest;
+    std::cout<<"size "<<b.size()<<", newest "<<(*newest).first.val<<std::endl;
+
+    compact copy(b);
+    check(same_order(a, copy));
+    compact assigned;
+    assigned = copy;
+    check(same_order(a, assigned));
+
+    // a moved-from map is empty and still usable
+    compact moved(std::move(assigned));
+    check(same_order(a, moved) && assigned.empty() && assigned.begin() == assigned.end());
+    check(assigned.find(Integer(1)) == assigned.end() && !assigned.count(1));
+    for(int i = 0; i < 100; i++) assigned.insert(value_type(Integer(i), Matrix<int>(1, 1, i)));
+    check(assigned.size() == 100 && assigned.at(Integer(99))[0][0] == 99);
+    moved = std::move(assigned);
+    check(moved.size() == 100 && same_order(a, assigned));
+
+    b.clear();
+    check(b.empty() && b.find(Integer(3)) == b.end());
+    bool thrown = false;
+    try{ b.at(Integer(1)); }catch(sjtu::index_out_of_bound &){ thrown = true; }
+    check(thrown);
+
+    // values stay put while the slab has room
+    for(int i = 0; i < 5000; i++) b.insert_unique(value_type(Integer(i), Matrix<int>(1, 1, i)));
+    for(int i = 0; i < 5000; i++) check(b.at(i)[0][0] == i);
+    b.reserve(20000);
+    const Matrix<int> *kept = &b.at(10);
+    for(int i = 5000; i < 20000; i++) b.insert(value_type(Integer(i), Matrix<int>()));
+    check(kept == &b.at(10) && b.size() == 20000);
+    int n = 0;
+    for(auto it = b.cbegin(); it != b.cend(); ++it, ++n) if(n < 3) std::cout<<(*it).first.val<<" "<<(*it).second<<std::endl;
+    std::cout<<n<<" in order"<<std::endl;
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("22.out","w",stdout);
+#endif
+    compact_hashmap_tester();
+    std::cout << c[2] << std::endl;
+}
@@ -0,0 +1,108 @@
+#include "src.hpp"
+#include "thread-pool.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cstdio>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void check(bool ok){
+    if(!ok){
+        std::cout<<c[1]<<std::endl;
+        exit(0);
+    }
+}
+
+Matrix<int> filled(size_t rows, size_t cols, int seed){
+    Matrix<int> mat(rows, cols);
+    for(size_t i = 0; i < rows; i++){
+        for(size_t j = 0; j < cols; j++) mat[i][j] = int((i * 31 + j * 17 + seed) % 23) - 11;
+    }
+    return mat;
+}
+
+void thread_pool_tester(){
+    sjtu::thread_pool pool(4);
+    check(pool.size() == 4 && sjtu::thread_pool(0).size() == 1);
+
+    // every index is visited exactly once, whatever the grain
+    for(size_t grain : {size_t(0), size_t(1), size_t(7), size_t(1000), size_t(200000)}){
+        std::vector<int> seen(100003, 0);
+        pool.parallel_for(0, seen.size(), grain, [&seen](size_t lo, size_t hi){
+            for(size_t i = lo; i < hi; i++) seen[i]++;
+        });
+        for(int s : seen) check(s == 1);
+    }
+    pool.parallel_for(5, 5, 1, [](size_t, size_t){ check(false); });
+
+    // nested loops on the same pool finish and match the serial sums
+    const size_t outer = 64, inner = 5000;
+    std::vector<long> parallel(outer, 0), serial(outer, 0);
+    pool.parallel_for(0, outer, 1, [&](size_t lo, size_t hi){
+        for(size_t i = lo; i < hi; i++){
+            std::vector<long> part(inner, 0);
+            pool.parallel_for(0, inner, 64, [&](size_t a, size_t b){
+                for(size_t j = a; j < b; j++) part[j] = long(i * j % 97);
+            });
+            for(long v : part) parallel[i] += v;
+        }
+    });
+    for(size_t i = 0; i < outer; i++){
+        for(size_t j = 0; j < inner; j++) serial[i] += long(i * j % 97);
+    }
+    check(parallel == serial);
+    std::cout<<"nested sum "<<parallel[outer - 1]<<std::endl;
+
+    // the first exception of a chunk comes back to the caller
+    bool thrown = false;
+    try{
+        pool.parallel_for(0, 1000, 10, [](size_t lo, size_t){ if(lo == 500) throw std::runtime_error("chunk"); });
+    }catch(std::runtime_error &){
+        thrown = true;
+    }
+    check(thrown);
+
+    std::atomic<int> ran(0);
+    for(int i = 0; i < 100; i++) pool.submit([&ran]{ ran++; });
+    while(ran < 100) if(!pool.run_one()) std::this_thread::yield();
+
+    // the matrix operators give the same results split over the pool
+    Matrix<int> a = filled(97, 61, 1), b = filled(61, 83, 2), d = filled(97, 61, 3);
+    const size_t threshold = MatrixExecutor::Threshold();
+    MatrixExecutor::Threshold() = size_t(-1);
+    Matrix<int> product = a * b, sum = a + d * 2 - a, flipped = Transpose(a), negated = -(a + d);
+    {
+        MatrixExecutor scope(pool);
+        MatrixExecutor::Threshold() = 1;
+        check(a * b == product);
+        check(MultiplyTransposed(a, Transpose(b)) == product);
+        Matrix<int> fused = a + d * 2 - a;
+        check(fused == sum && Transpose(a) == flipped && -(a + d) == negated);
+        // a product computed inside a parallel loop nests on the same pool
+        std::vector<Matrix<int> > rows(8);
+        pool.parallel_for(0, rows.size(), 1, [&](size_t lo, size_t hi){
+            for(size_t i = lo; i < hi; i++) rows[i] = a * b;
+        });
+        for(auto &m : rows) check(m == product);
+    }
+    MatrixExecutor::Threshold() = threshold;
+    std::cout<<"product corner "<<product[0][0]<<" "<<product[96][82]<<std::endl;
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("23.out","w",stdout);
+#endif
+    thread_pool_tester();
+    std::cout << c[2] << std::endl;
+}
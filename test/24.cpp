@@ -0,0 +1,114 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+// every Matrix buffer is one make_shared, so counting plain news counts the matrices made
+long allocations = 0;
+void *operator new(std::size_t n){
+    allocations++;
+    if(void *p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+void check(bool ok){
+    if(!ok){
+        std::cout<<c[1]<<std::endl;
+        exit(0);
+    }
+}
+
+Matrix<int> filled(size_t rows, size_t cols, int seed){
+    Matrix<int> mat(rows, cols);
+    for(size_t i = 0; i < rows; i++){
+        for(size_t j = 0; j < cols; j++) mat[i][j] = int((i * 13 + j * 7 + seed) % 19) - 9;
+    }
+    return mat;
+}
+
+void expression_tester(){
+    const size_t n = 40, m = 30;
+    const Matrix<int> a = filled(n, m, 1), b = filled(n, m, 2), d = filled(n, m, 3), e = filled(m, m, 4);
+    long before = allocations;
+    Matrix<int> one(n, m);
+    const long per_matrix = allocations - before;
+    check(per_matrix > 0);
+
+    // a + b * 3 - d, fused into the one new matrix
+    before = allocations;
+    Matrix<int> fused = a + b * 3 - d;
+    check(allocations - before == per_matrix);
+    for(size_t i = 0; i < n; i++){
+        for(size_t j = 0; j < m; j++) check(fused[i][j] == a[i][j] + b[i][j] * 3 - d[i][j]);
+    }
+
+    // assigned into an unshared matrix of the same shape, nothing is allocated
+    before = allocations;
+    one = -(a - d) + fused / 2.0;
+    check(allocations == before);
+    for(size_t i = 0; i < n; i++){
+        for(size_t j = 0; j < m; j++) check(one[i][j] == int(-(a[i][j] - d[i][j]) + fused[i][j] / 2.0));
+    }
+
+    // a product inside a sum materializes once, the sum is fused around it
+    before = allocations;
+    Matrix<int> product = b * e;
+    const long per_product = allocations - before;
+    before = allocations;
+    Matrix<int> mixed = a + b * e;
+    check(allocations - before == per_product + per_matrix && mixed - a == product);
+    for(size_t i = 0; i < n; i++){
+        for(size_t j = 0; j < m; j++){
+            int dot = 0;
+            for(size_t k = 0; k < m; k++) dot += b[i][k] * e[k][j];
+            check(mixed[i][j] == a[i][j] + dot);
+        }
+    }
+
+    // the target appears in its own expression
+    Matrix<int> square = filled(m, m, 5), eager(m, m);
+    const Matrix<int> old = square;
+    for(size_t i = 0; i < m; i++){
+        for(size_t j = 0; j < m; j++) eager[i][j] = old[i][j] + old[j][i];
+    }
+    square = square + Transpose(square);
+    check(square == eager && old == filled(m, m, 5));
+    before = allocations;
+    fused = fused * 2 + fused - a;
+    check(allocations == before);
+    for(size_t i = 0; i < n; i++){
+        for(size_t j = 0; j < m; j++) check(fused[i][j] == (a[i][j] + b[i][j] * 3 - d[i][j]) * 3 - a[i][j]);
+    }
+
+    // a shared target gets a new buffer, its twin keeps the old values
+    Matrix<int> twin = fused;
+    fused = fused + a;
+    check(twin == fused - a && !twin.Shared());
+
+    bool thrown = false;
+    try{ Matrix<int> bad = a + e; }catch(std::invalid_argument &){ thrown = true; }
+    check(thrown);
+    std::cout<<"fused "<<fused[0][0]<<" "<<fused[n - 1][m - 1]<<", mixed "<<mixed[3][4]<<", square "<<square[1][2]<<std::endl;
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("24.out","w",stdout);
+#endif
+    expression_tester();
+    std::cout << c[2] << std::endl;
+}
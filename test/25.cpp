@@ -0,0 +1,85 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cstdio>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void check(bool ok){
+    if(!ok){
+        std::cout<<c[1]<<std::endl;
+        exit(0);
+    }
+}
+
+using value_type = sjtu::pair<Integer,Matrix<int> >;
+
+void copy_tester(){
+    Matrix<int> a(3, 4, 1);
+    Matrix<int> b = a;
+    check(a.Shared() && b.Shared() && a.Data() != b.Data());
+    check(!a.Shared() && !b.Shared());
+    Matrix<int> d = a;
+    d[1][2] = 9;
+    check(a[1][2] == 1 && d[1][2] == 9 && a == b);
+    const Matrix<int> e = b;
+    check(e.Shared() && static_cast<const Matrix<int> &>(b).Data() == e.Data());
+    std::cout<<"copy on write"<<c[0]<<std::endl;
+}
+
+void handle_tester(){
+    sjtu::lru cache(3);
+    for(int i = 0; i < 3; i++) cache.save(value_type(Integer(i), Matrix<int>(2, 2, i)));
+    Matrix<int> zero = cache.lookup(Integer(0));
+    Matrix<int> one = cache.lookup(1);
+    check(zero.Shared() && one.Shared() && zero == Matrix<int>(2, 2, 0));
+
+    // updated: the handle keeps the old value
+    cache.save(value_type(Integer(1), Matrix<int>(3, 1, 7)));
+    check(one == Matrix<int>(2, 2, 1) && !one.Shared());
+    check(*cache.get(Integer(1)) == Matrix<int>(3, 1, 7));
+
+    // evicted: 0 is the oldest after the lookups of 1 and 2
+    Matrix<int> two, gone;
+    check(cache.try_lookup(2, two) && two == Matrix<int>(2, 2, 2));
+    cache.save(value_type(Integer(3), Matrix<int>(1, 1, 3)));
+    check(!cache.try_lookup(0, gone) && zero == Matrix<int>(2, 2, 0) && !zero.Shared());
+
+    // removed and cleared
+    check(cache.remove(Integer(2)) && two == Matrix<int>(2, 2, 2));
+    Matrix<int> three = cache.lookup(Integer(3));
+    cache.clear();
+    check(three == Matrix<int>(1, 1, 3) && !three.Shared());
+
+    // writes on either side never reach the other
+    cache.save(value_type(Integer(4), Matrix<int>(2, 2, 4)));
+    Matrix<int> four = cache.lookup(Integer(4));
+    four[0][0] = -1;
+    check((*cache.get(Integer(4)))[0][0] == 4);
+    four = cache.lookup(Integer(4));
+    (*cache.get(Integer(4)))[1][1] = -2;
+    check(four == Matrix<int>(2, 2, 4) && (*cache.get(Integer(4)))[1][1] == -2);
+
+    // the documented caveat: a row taken before the lookup still writes into the shared buffer
+    auto row = (*cache.get(Integer(4)))[0];
+    Matrix<int> late = cache.lookup(Integer(4));
+    row[0] = 5;
+    check(late[0][0] == 5);
+    std::cout<<"lookup handles"<<c[0]<<std::endl;
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("25.out","w",stdout);
+#endif
+    copy_tester();
+    handle_tester();
+    std::cout << c[2] << std::endl;
+}
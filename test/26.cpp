@@ -0,0 +1,161 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void check(bool ok){
+    if(!ok){
+        std::cout<<c[1]<<std::endl;
+        exit(0);
+    }
+}
+
+// the batches of a walk over n values: all full but the last, none empty
+void check_batches(const std::vector<size_t> &sizes, size_t n, size_t batch){
+    size_t full = batch == 0 || batch > 64 ? 64 : batch, total = 0;
+    for(size_t i = 0; i < sizes.size(); i++){
+        check(sizes[i] > 0 && sizes[i] <= full);
+        if(i + 1 < sizes.size()) check(sizes[i] == full);
+        total += sizes[i];
+    }
+    check(total == n && sizes.size() == (n + full - 1) / full);
+}
+
+const size_t batches[] = {0, 1, 7, 16, 64, 100, 1000};
+
+void list_tester(){
+    sjtu::double_list<int> list;
+    int calls = 0;
+    list.for_each([&](int){ calls++; });
+    list.for_each_batch([&](int **, size_t){ calls++; });
+    check(calls == 0);
+    const int n = 150;
+    for(int i = 0; i < n; i++) list.insert_tail(i);
+    std::vector<int> seen;
+    list.for_each([&](int v){ seen.push_back(v); });
+    check(seen.size() == n);
+    for(int i = 0; i < n; i++) check(seen[i] == i);
+    for(size_t batch : batches){
+        std::vector<size_t> sizes;
+        seen.clear();
+        list.for_each_batch([&](int **values, size_t k){
+            sizes.push_back(k);
+            for(size_t i = 0; i < k; i++) seen.push_back(*values[i]);
+        }, batch);
+        check_batches(sizes, n, batch);
+        for(int i = 0; i < n; i++) check(seen[i] == i);
+    }
+    std::cout<<"double_list for_each"<<c[0]<<std::endl;
+}
+
+void hashmap_tester(){
+    using value_type = sjtu::pair<const int,int>;
+    sjtu::hashmap<int,int> map;
+    const int n = 777;
+    for(int i = 0; i < n; i++) map.insert(value_type(i * 7919 % 1000, i));
+    std::vector<int> hits(1000, 0);
+    int last = 0;
+    map.for_each([&](value_type &v){
+        check(map.pos(v.first) >= last);
+        last = map.pos(v.first);
+        hits[v.first]++;
+    });
+    for(int i = 0; i < n; i++) check(hits[i * 7919 % 1000] == 1);
+    for(size_t batch : batches){
+        std::vector<size_t> sizes;
+        std::vector<int> seen(1000, 0);
+        last = 0;
+        map.for_each_batch([&](value_type **values, size_t k){
+            sizes.push_back(k);
+            for(size_t i = 0; i < k; i++){
+                check(map.pos(values[i]->first) >= last);
+                last = map.pos(values[i]->first);
+                seen[values[i]->first]++;
+            }
+        }, batch);
+        check_batches(sizes, n, batch);
+        check(seen == hits);
+    }
+    std::cout<<"hashmap for_each"<<c[0]<<std::endl;
+}
+
+void linked_hashmap_tester(){
+    using value_type = sjtu::pair<const int,int>;
+    using mp = sjtu::linked_hashmap<int,int>;
+    mp map;
+    std::vector<int> order;
+    for(int i = 0; i < 1000; i++){
+        map.insert(value_type(i * 7919 % 1000, i));
+        order.push_back(i * 7919 % 1000);
+    }
+    // drop every third key, put a few back at the tail
+    std::vector<int> kept;
+    for(size_t i = 0; i < order.size(); i++){
+        if(i % 3 == 0) map.remove(map.find(order[i]));
+        else kept.push_back(order[i]);
+    }
+    for(size_t i = 0; i < order.size(); i += 30){
+        map.insert(value_type(order[i], -1));
+        kept.push_back(order[i]);
+    }
+    const size_t n = kept.size();
+    check(map.size() == n);
+
+    std::vector<int> seen;
+    map.for_each([&](value_type &v){ seen.push_back(v.first); });
+    check(seen == kept);
+    seen.clear();
+    const mp &cmap = map;
+    cmap.for_each([&](const value_type &v){ seen.push_back(v.first); });
+    check(seen == kept);
+    for(size_t batch : batches){
+        std::vector<size_t> sizes;
+        seen.clear();
+        cmap.for_each_batch([&](value_type **values, size_t k){
+            sizes.push_back(k);
+            for(size_t i = 0; i < k; i++) seen.push_back(values[i]->first);
+        }, batch);
+        check_batches(sizes, n, batch);
+        check(seen == kept);
+    }
+
+    std::vector<int> hits(1000, 0);
+    int last = 0;
+    size_t visits = 0;
+    cmap.for_each_bucket([&](const value_type &v){
+        check(map.pos(v.first) >= last);
+        last = map.pos(v.first);
+        hits[v.first]++;
+        visits++;
+    });
+    check(visits == n);
+    for(int key : kept) check(hits[key] == 1);
+
+    mp empty;
+    int calls = 0;
+    empty.for_each([&](value_type &){ calls++; });
+    empty.for_each_bucket([&](value_type &){ calls++; });
+    empty.for_each_batch([&](value_type **, size_t){ calls++; });
+    check(calls == 0);
+    std::cout<<"linked_hashmap for_each"<<c[0]<<std::endl;
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("26.out","w",stdout);
+#endif
+    list_tester();
+    hashmap_tester();
+    linked_hashmap_tester();
+    std::cout << c[2] << std::endl;
+}
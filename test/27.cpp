@@ -0,0 +1,126 @@
+#include "src.hpp"
+#include "robin-hood.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void check(bool ok){
+    if(!ok){
+        std::cout<<c[1]<<std::endl;
+        exit(0);
+    }
+}
+
+using entry = sjtu::pair<int,int>;
+
+// distinct keys in a scrambled order, value = 3 * key + salt
+std::vector<entry> entries(int n, int salt){
+    std::vector<entry> v;
+    for(int i = 0; i < n; i++){
+        int key = (i * 7919 + salt) % (2 * n);
+        v.push_back(entry(key, 3 * key + salt));
+    }
+    return v;
+}
+
+template <class Map>
+void check_contents(Map &map, const std::vector<entry> &expected){
+    check(map.size() == expected.size());
+    size_t i = 0;
+    for(auto it = map.begin(); it != map.end(); ++it, ++i){
+        check(i < expected.size() && it->first == expected[i].first && it->second == expected[i].second);
+    }
+    check(i == expected.size());
+    for(const entry &e : expected){
+        auto it = map.find(e.first);
+        check(it != map.end() && it->second == e.second);
+    }
+}
+
+template <class Map>
+void build_tester(Map &map, const char *name){
+    using value_type = typename Map::value_type;
+    // a map that already holds keys, some of them kept, some dropped
+    for(int i = 0; i < 300; i++) map.insert(value_type(i, -i));
+    const std::vector<entry> input = entries(500, 1);
+    map.build_from(input);
+    check_contents(map, input);
+    check(map.find(2 * 500) == map.end());
+    for(int key = 0; key < 300; key++){
+        auto it = map.find(key);
+        check(it == map.end() || it->second == 3 * key + 1);
+    }
+
+    // still an ordinary map afterwards
+    map.insert(value_type(5000, 1));
+    map.remove(map.find(input[0].first));
+    std::vector<entry> expected(input.begin() + 1, input.end());
+    expected.push_back(entry(5000, 1));
+    check_contents(map, expected);
+
+    // the iterator overload, and an empty range
+    const std::vector<entry> small = entries(20, 7);
+    map.build_from(small.begin(), small.end());
+    check_contents(map, small);
+    map.build_from(std::vector<entry>());
+    check(map.size() == 0 && map.begin() == map.end());
+    map.insert(value_type(1, 1));
+    check(map.size() == 1 && map.find(1)->second == 1);
+    std::cout<<name<<" build_from"<<c[0]<<std::endl;
+}
+
+void reserve_tester(){
+    using value_type = sjtu::pair<const int,int>;
+    {
+        sjtu::hashmap<int,int> map;
+        for(int n : {1, 10, 13, 100, 1000, 4321}){
+            map.clear();
+            map.insert(value_type(-1, 0));
+            map.reserve(n);
+            const int capacity = map.capacity;
+            for(int i = 0; map.size < n; i++) map.insert(value_type(i, i));
+            check(map.capacity == capacity);
+        }
+    }
+    {
+        sjtu::linked_hashmap<int,int> map;
+        for(int n : {7, 75, 750, 7500}){
+            map.reserve(n);
+            const int capacity = map.capacity;
+            for(int i = static_cast<int>(map.size()); i < n; i++) map.insert(value_type(i, i));
+            check(map.capacity == capacity && static_cast<int>(map.size()) == n);
+        }
+    }
+    {
+        sjtu::linked_robin_hashmap<int,int> map;
+        for(int n : {7, 75, 750, 7500}){
+            map.reserve(n);
+            const std::uint32_t capacity = map.index.capacity();
+            for(int i = static_cast<int>(map.size()); i < n; i++) map.insert(value_type(i, i));
+            check(map.index.capacity() == capacity && static_cast<int>(map.size()) == n);
+        }
+    }
+    std::cout<<"reserve"<<c[0]<<std::endl;
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("27.out","w",stdout);
+#endif
+    sjtu::linked_hashmap<int,int> linked;
+    build_tester(linked, "linked_hashmap");
+    sjtu::linked_robin_hashmap<int,int> robin;
+    build_tester(robin, "linked_robin_hashmap");
+    reserve_tester();
+    std::cout << c[2] << std::endl;
+}
@@ -0,0 +1,110 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void check(bool ok){
+    if(!ok){
+        std::cout<<c[1]<<std::endl;
+        exit(0);
+    }
+}
+
+using value_type = sjtu::pair<const int,int>;
+using mp = sjtu::linked_hashmap<int,int>;
+
+void shrink_to_fit_tester(){
+    mp map;
+    const int n = 20000;
+    for(int i = 0; i < n; i++) map.insert(value_type(i, i));
+    const int grown = map.capacity;
+    for(int i = 0; i < n; i += 4) map.remove(map.find(i));
+    check(map.capacity == grown);
+    map.shrink_to_fit();
+    const int left = static_cast<int>(map.size());
+    check(map.capacity < grown && map.capacity >= left / map.load_factor && map.capacity <= left / map.load_factor + 1);
+    int expected = 1;
+    for(auto it = map.begin(); it != map.end(); ++it){
+        if(expected % 4 == 0) expected++;
+        check(it->first == expected && it->second == expected);
+        expected++;
+    }
+    check(expected == n);
+    for(int i = 1; i < n; i += 4) check(map.find(i) != map.end() && map.count(i + 3) == 0 && map.count(i + 2) == 1);
+
+    map.clear();
+    map.shrink_to_fit();
+    check(map.capacity == mp::min_capacity && map.size() == 0);
+    map.insert(value_type(1, 1));
+    check(map.find(1)->second == 1);
+    std::cout<<"shrink_to_fit"<<c[0]<<std::endl;
+}
+
+// remove down to target, count how often the buckets were rebuilt
+int removals(mp &map, int &next, int target){
+    int shrinks = 0, capacity = map.capacity;
+    while(static_cast<int>(map.size()) > target){
+        map.remove(map.find(next++));
+        if(map.capacity != capacity){
+            check(map.capacity < capacity);
+            // half full right after a shrink, well above the next trigger
+            check(map.size() <= map.capacity * map.load_factor * 0.5);
+            check(map.size() > map.capacity * map.load_factor * map.shrink_threshold);
+            capacity = map.capacity;
+            shrinks++;
+        }
+    }
+    return shrinks;
+}
+
+void auto_shrink_tester(){
+    const int n = 20000;
+    for(double threshold : {0.1, 0.25, 0.5, 0.75, 1.0}){
+        mp map;
+        map.set_shrink_threshold(threshold);
+        for(int i = 0; i < n; i++) map.insert(value_type(i, i));
+        const int grown = map.capacity;
+        int next = 0;
+        // each shrink needs half of what is left to go, so a handful at most
+        int shrinks = removals(map, next, n / 2);
+        shrinks += removals(map, next, 10);
+        check(shrinks >= 1 && shrinks <= 12 && map.capacity < grown);
+        for(int i = next; i < n; i++) check(map.find(i) != map.end() && map.find(i)->second == i);
+
+        // growing back only expands, and the order survives
+        const int capacity = map.capacity;
+        for(int i = 0; i < next; i++) map.insert(value_type(i, -i));
+        check(map.capacity >= capacity && static_cast<int>(map.size()) == n);
+        auto it = map.begin();
+        for(int i = next; i < n; i++, ++it) check(it->first == i);
+        for(int i = 0; i < next; i++, ++it) check(it->first == i && it->second == -i);
+    }
+
+    mp never;
+    for(int i = 0; i < 1000; i++) never.insert(value_type(i, i));
+    const int grown = never.capacity;
+    for(int i = 0; i < 999; i++) never.remove(never.find(i));
+    check(never.capacity == grown);
+    never.set_shrink_threshold(0.2);
+    check(never.capacity < grown && never.find(999) != never.end());
+    std::cout<<"auto shrink"<<c[0]<<std::endl;
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("28.out","w",stdout);
+#endif
+    shrink_to_fit_tester();
+    auto_shrink_tester();
+    std::cout << c[2] << std::endl;
+}
@@ -0,0 +1,135 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cstdio>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void check(bool ok){
+    if(!ok){
+        std::cout<<c[1]<<std::endl;
+        exit(0);
+    }
+}
+
+using value_type = sjtu::pair<const int,int>;
+using mp = sjtu::linked_hashmap<int,int>;
+using list = sjtu::double_list<int>;
+
+// the move constructors allocate the source's fresh state, the rest only swap
+static_assert(!std::is_nothrow_move_constructible<mp>::value, "");
+static_assert(std::is_nothrow_move_assignable<mp>::value, "");
+static_assert(std::is_nothrow_move_assignable<list>::value, "");
+
+mp filled(int from, int to){
+    mp map;
+    for(int i = from; i < to; i++) map.insert(value_type(i, i * i));
+    return map;
+}
+
+bool holds(mp &map, int from, int to){
+    if(static_cast<int>(map.size()) != to - from) return false;
+    int i = from;
+    for(auto it = map.begin(); it != map.end(); ++it, ++i){
+        if(it->first != i || it->second != i * i) return false;
+    }
+    for(i = from; i < to; i++){
+        if(map.find(i) == map.end() || map.at(i) != i * i) return false;
+    }
+    return true;
+}
+
+void list_tester(){
+    list a;
+    for(int i = 0; i < 10; i++) a.insert_tail(i);
+    list b(std::move(a));
+    check(a.empty() && a.begin() == a.end() && !b.empty() && *b.begin() == 0);
+    a.insert_tail(42);
+    check(!a.empty() && *a.begin() == 42);
+
+    // swapping the heads carries every iterator, end() included, along
+    list::iterator first = b.begin(), last = --b.end(), past = b.end();
+    a.swap(b);
+    check(*b.begin() == 42 && ++b.begin() == b.end());
+    check(first == a.begin() && last == --a.end() && past == a.end() && *last == 9);
+    int n = 0;
+    for(list::iterator it = first; it != a.end(); ++it) check(*it == n++);
+    check(n == 10);
+    b = std::move(a);
+    check(*b.begin() == 0 && *a.begin() == 42);
+    std::cout<<"double_list moves"<<c[0]<<std::endl;
+}
+
+void hashmap_tester(){
+    sjtu::hashmap<int,int> a;
+    for(int i = 0; i < 100; i++) a.insert(value_type(i, i));
+    const int capacity = a.capacity;
+    sjtu::hashmap<int,int> b(std::move(a));
+    check(b.size == 100 && b.capacity == capacity && b.find(7)->second == 7);
+    check(a.size == 0 && a.capacity == sjtu::hashmap<int,int>::min_capacity && a.find(7) == a.end());
+    for(int i = 0; i < 50; i++) a.insert(value_type(i, -i));
+    check(a.size == 50 && a.find(49)->second == -49 && a.remove(0) && !a.remove(0));
+    std::cout<<"hashmap moves"<<c[0]<<std::endl;
+}
+
+void linked_hashmap_tester(){
+    mp a = filled(0, 100);
+    mp b(std::move(a));
+    check(holds(b, 0, 100) && holds(a, 0, 0) && a.empty());
+    check(a.find(1) == a.end() && a.count(1) == 0);
+    bool thrown = false;
+    try{ a.at(1); }catch(sjtu::index_out_of_bound &){ thrown = true; }
+    check(thrown);
+
+    // the moved-from map works like a new one: it grows, removes, copies
+    for(int i = 0; i < 300; i++) a.insert(value_type(i, i * i));
+    check(holds(a, 0, 300));
+    for(int i = 0; i < 100; i++) a.remove(a.find(i));
+    check(holds(a, 100, 300));
+    mp copy(a);
+    check(holds(copy, 100, 300));
+
+    // moved-from by assignment: it holds the target's old elements
+    mp d = filled(5, 8);
+    d = std::move(copy);
+    check(holds(d, 100, 300) && holds(copy, 5, 8));
+    copy.clear();
+    copy.insert(value_type(3, 9));
+    check(holds(copy, 3, 4));
+
+    // iterators follow their elements into the other map
+    mp e = filled(0, 10), f = filled(20, 25);
+    mp::iterator in_e = e.find(4), e_end = e.end(), in_f = f.find(22);
+    e.swap(f);
+    check(holds(e, 20, 25) && holds(f, 0, 10));
+    check(in_e == f.find(4) && in_f == e.find(22) && e_end == f.end());
+    int n = 4;
+    for(mp::iterator it = in_e; it != f.end(); ++it) check(it->first == n++);
+    check(n == 10);
+    f.remove(in_e);
+    e.remove(in_f);
+    check(f.size() == 9 && f.find(4) == f.end() && e.size() == 4 && e.find(22) == e.end());
+    in_e = f.begin();
+    f = std::move(e);
+    check(in_e == e.begin() && in_e->first == 0 && f.begin()->first == 20);
+    std::cout<<"linked_hashmap moves"<<c[0]<<std::endl;
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("29.out","w",stdout);
+#endif
+    list_tester();
+    hashmap_tester();
+    linked_hashmap_tester();
+    std::cout << c[2] << std::endl;
+}
@@ -0,0 +1,122 @@
+#include "src.hpp"
+#include "robin-hood.hpp"
+#include "compact-hashmap.hpp"
+#include "concurrent-hashmap.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cstdio>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void check(bool ok){
+    if(!ok){
+        std::cout<<c[1]<<std::endl;
+        exit(0);
+    }
+}
+
+// a temporary Integer is gone again once the call returns, so the
+// functors note the counter while the lookup runs: it only rises there
+// if the key was turned into an Integer
+int peak = 0;
+void note(){
+    if(Integer::counter > peak) peak = Integer::counter;
+}
+class PeekHash : public Hash {
+public:
+    template <class K>
+    unsigned int operator()(const K &key) const {
+        note();
+        return Hash::operator()(key);
+    }
+};
+class PeekEqual : public Equal {
+public:
+    template <class A, class B>
+    bool operator()(const A &a, const B &b) const {
+        note();
+        return Equal::operator()(a, b);
+    }
+};
+
+// run fn, return whether no Integer was alive beyond those before it
+template <class Fn>
+bool no_integer(Fn fn){
+    const int before = Integer::counter;
+    peak = before;
+    fn();
+    return peak == before && Integer::counter == before;
+}
+
+template <class Map>
+void map_tester(Map &map, const char *name){
+    using value_type = typename Map::value_type;
+    for(int i = 0; i < 100; i++) map.insert(value_type(Integer(i), i * 2));
+    const Map &cmap = map;
+    check(no_integer([&]{ check(map.find(42) != map.end() && map.find(42)->second == 84); }));
+    check(no_integer([&]{ check(map.find(-1) == map.end()); }));
+    check(no_integer([&]{ check(map.count(7) == 1 && map.count(100) == 0 && cmap.count(99) == 1); }));
+    check(no_integer([&]{ check(map.at(5) == 10 && cmap.at(6) == 12); map.at(5) = 11; }));
+    check(no_integer([&]{
+        bool thrown = false;
+        try{ map.at(1000); }catch(sjtu::index_out_of_bound &){ thrown = true; }
+        check(thrown);
+    }));
+    check(map.at(Integer(5)) == 11);
+    // and the peek does see a key that is an Integer
+    check(!no_integer([&]{ check(map.count(Integer(7)) == 1); }));
+    std::cout<<name<<c[0]<<std::endl;
+}
+
+void concurrent_tester(){
+    sjtu::concurrent_hashmap<Integer,int,PeekHash,PeekEqual> map;
+    for(int i = 0; i < 100; i++) map.insert(sjtu::pair<const Integer,int>(Integer(i), i * 3));
+    int out = 0;
+    check(no_integer([&]{ check(map.find(42, out) && out == 126 && !map.find(-1, out)); }));
+    check(no_integer([&]{ check(map.count(7) == 1 && map.count(100) == 0); }));
+    check(!no_integer([&]{ check(map.count(Integer(7)) == 1); }));
+    std::cout<<"concurrent_hashmap"<<c[0]<<std::endl;
+}
+
+void lru_tester(){
+    // lru always uses Hash and Equal, so only the count is left to look at
+    sjtu::lru cache(10);
+    for(int i = 0; i < 10; i++) cache.save(sjtu::pair<Integer,Matrix<int> >(Integer(i), Matrix<int>(1, 1, i)));
+    const int before = Integer::counter;
+    check((*cache.get(3))[0][0] == 3 && cache.lookup(4)[0][0] == 4);
+    Matrix<int> value;
+    check(cache.try_lookup(5, value) && value[0][0] == 5 && !cache.try_lookup(50, value));
+    bool thrown = false;
+    try{ cache.get(50); }catch(sjtu::index_out_of_bound &){ thrown = true; }
+    check(thrown && Integer::counter == before);
+    std::cout<<"lru"<<c[0]<<std::endl;
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("30.out","w",stdout);
+#endif
+    {
+        sjtu::linked_hashmap<Integer,int,PeekHash,PeekEqual> map;
+        map_tester(map, "linked_hashmap");
+    }
+    {
+        sjtu::linked_robin_hashmap<Integer,int,PeekHash,PeekEqual> map;
+        map_tester(map, "linked_robin_hashmap");
+    }
+    {
+        sjtu::compact_linked_hashmap<Integer,int,PeekHash,PeekEqual> map;
+        map_tester(map, "compact_linked_hashmap");
+    }
+    concurrent_tester();
+    lru_tester();
+    check(Integer::counter == 0);
+    std::cout << c[2] << std::endl;
+}
@@ -0,0 +1,133 @@
+#include "src.hpp"
+#include "concurrent-hashmap.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cstdio>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void check(bool ok){
+    if(!ok){
+        std::cout<<c[1]<<std::endl;
+        exit(0);
+    }
+}
+
+using value_type = sjtu::pair<const Integer,Matrix<int> >;
+using map_type = sjtu::concurrent_hashmap<Integer,Matrix<int>,Hash,Equal>;
+
+// every value ever stored for key k is one of these two
+int value_of(int k, bool second){
+    return second ? -3 * k - 1 : 3 * k;
+}
+Matrix<int> matrix_of(int k, bool second){
+    return Matrix<int>(1, 2, value_of(k, second));
+}
+bool whole(const Matrix<int> &m, int k){
+    if(m.RowSize() != 1 || m.ColSize() != 2 || m[0][0] != m[0][1]) return false;
+    return m[0][0] == value_of(k, false) || m[0][0] == value_of(k, true);
+}
+
+void concurrent_stress_tester(){
+    const int writers = 8, readers = 8, per = 2000, shared = 500;
+    map_type map(16);  // grows many times while the readers walk it
+    std::atomic<int> bad(0), writing(writers);
+    std::atomic<long> reads(0);
+    std::vector<std::thread> workers;
+    for(int t = 0; t < writers; t++){
+        workers.emplace_back([&, t](){
+            unsigned seed = t * 2654435761u + 1;
+            for(int i = 0; i < per; i++){
+                // keys of its own: insert, read back, remove every fourth one again
+                int k = shared + t * per + i;
+                if(!map.insert(value_type(Integer(k), matrix_of(k, false)))) bad++;
+                Matrix<int> v;
+                if(!map.find(k, v) || !(v == matrix_of(k, false))) bad++;
+                if(i % 4 == 3){
+                    if(!map.remove(Integer(k - 1)) || map.count(k - 1)) bad++;
+                    if(!map.touch(Integer(k - 2))) bad++;
+                }
+                // keys everyone fights over
+                seed = seed * 1103515245u + 12345u;
+                int s = (seed >> 8) % shared;
+                switch((seed >> 4) % 4){
+                    case 0: map.insert(value_type(Integer(s), matrix_of(s, t % 2))); break;
+                    case 1: map.remove(Integer(s)); break;
+                    case 2: map.touch(Integer(s)); break;
+                    default:
+                        if(map.find(s, v) && !whole(v, s)) bad++;
+                }
+            }
+            writing--;
+        });
+    }
+    for(int t = 0; t < readers; t++){
+        workers.emplace_back([&, t](){
+            unsigned seed = t * 40503u + 7;
+            long n = 0;
+            // a last round after the writers are done, so every reader runs
+            for(bool last = false; !last; n++){
+                last = writing == 0;
+                seed = seed * 1103515245u + 12345u;
+                int s = (seed >> 8) % shared;
+                Matrix<int> v;
+                if(map.find(s, v) && !whole(v, s)) bad++;
+                // whatever the value handed out, it outlives its entry
+                v = Matrix<int>();
+                int o = shared + (seed >> 4) % (writers * per);
+                bool seen = map.visit(Integer(o), [&](const value_type &p){
+                    if(p.first.val != o || !(p.second == matrix_of(o, false))) bad++;
+                    v = p.second;
+                });
+                if(seen != (v.Size() != 0)) bad++;
+                if(map.count(o) && map.find(o, v) && !(v == matrix_of(o, false))) bad++;
+                if(seen && v[0][1] != value_of(o, false)) bad++;
+            }
+            reads += n;
+        });
+    }
+    for(auto &w : workers) w.join();
+    check(bad == 0 && reads >= readers);
+
+    size_t own = 0, contested = 0;
+    map.for_each([&](const value_type &p){
+        int k = p.first.val;
+        if(k < shared){
+            contested++;
+            check(whole(p.second, k));
+        }else{
+            own++;
+            check((k - shared) % per % 4 != 2 && p.second == matrix_of(k, false));
+        }
+    });
+    check(own == size_t(writers) * (per - per / 4) && map.size() == own + contested);
+    std::cout<<writers<<" writers, "<<readers<<" readers, "<<own<<" keys left"<<std::endl;
+
+    // drained from both ends, nothing is lost or seen twice
+    std::vector<int> left;
+    map.for_each([&](const value_type &p){ left.push_back(p.first.val); });
+    size_t n = 0;
+    while(map.remove_oldest()) n++;
+    check(n == left.size() && map.empty() && !map.count(left[0]));
+    map.clear();
+    check(map.empty() && map.insert(value_type(Integer(1), matrix_of(1, false))) && map.size() == 1);
+    std::cout<<"drained"<<c[0]<<std::endl;
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("31.out","w",stdout);
+#endif
+    concurrent_stress_tester();
+    std::cout << c[2] << std::endl;
+}
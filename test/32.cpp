@@ -0,0 +1,143 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void check(bool ok){
+    if(!ok){
+        std::cout<<c[1]<<std::endl;
+        exit(0);
+    }
+}
+
+using value_type = sjtu::pair<Integer,Matrix<int> >;
+
+// small entries, int_codec packs them into a fraction of the words
+Matrix<int> packable(int key, size_t n){
+    Matrix<int> mat(n, n);
+    for(size_t i = 0; i < n; i++){
+        for(size_t j = 0; j < n; j++) mat[i][j] = int((key + i * 3 + j) % 11);
+    }
+    return mat;
+}
+// full 32-bit noise, which no encoding makes smaller
+Matrix<int> noise(int key, size_t n){
+    Matrix<int> mat(n, n);
+    unsigned seed = key * 2654435761u + 1;
+    for(size_t i = 0; i < n; i++){
+        for(size_t j = 0; j < n; j++){
+            seed = seed * 1103515245u + 12345u;
+            mat[i][j] = int(seed ^ (seed << 16));
+        }
+    }
+    return mat;
+}
+
+void get_or_load_tester(){
+    for(int capacity : {1, 2, 3, 10}){
+        sjtu::lru cache(capacity);
+        cache.compress_cold(true);
+        int loads = 0;
+        auto loader = [&loads](const Integer &key, Matrix<int> &value){
+            loads++;
+            value = packable(key.val, 20);
+            return true;
+        };
+        for(int round = 0; round < 3; round++){
+            for(int key = 0; key < 3 * capacity; key++){
+                // the entry handed back is the newest one, never the frozen one
+                Matrix<int> *value = cache.get_or_load(Integer(key), loader);
+                check(value != nullptr && *value == packable(key, 20));
+            }
+        }
+        check(loads == 9 * capacity);
+        for(int key = 2 * capacity; key < 3 * capacity; key++){
+            check(*cache.get(Integer(key)) == packable(key, 20));
+        }
+    }
+    std::cout<<"get_or_load"<<c[0]<<std::endl;
+}
+
+// whether the value of key (a copy of make(key)) was encoded: a pointer
+// taken from get() sees it emptied once it is, as compress_cold() warns
+template <class Make>
+bool frozen_after(Make make, size_t n){
+    sjtu::lru cache(10);
+    cache.compress_cold(true);
+    for(int key = 0; key < 10; key++) cache.save(value_type(Integer(key), make(key, n)));
+    Matrix<int> *value = cache.get(Integer(0));
+    for(int key = 10; key < 19; key++) cache.save(value_type(Integer(key), make(key, n)));
+    bool frozen = value->Size() == 0;
+    check(*cache.get(Integer(0)) == make(0, n));
+    return frozen;
+}
+
+void footprint_tester(){
+    check(frozen_after(packable, 20) && frozen_after(packable, 12));
+    // the bookkeeping outweighs what encoding saves on these
+    check(!frozen_after(packable, 2) && !frozen_after(packable, 5));
+    check(!frozen_after(noise, 2) && !frozen_after(noise, 20));
+    std::cout<<"footprint"<<c[0]<<std::endl;
+}
+
+class collector : public sjtu::eviction_listener {
+public:
+    std::vector<sjtu::eviction> seen;
+    void on_evict(sjtu::eviction *batch, size_t n) override {
+        for(size_t i = 0; i < n; i++) seen.push_back(std::move(batch[i]));
+    }
+};
+
+void round_trip_tester(){
+    const int n = 40;
+    sjtu::lru cache(n);
+    collector listener;
+    cache.listen(&listener);
+    cache.compress_cold(true);
+    for(int key = 0; key < n; key++){
+        cache.save(value_type(Integer(key), key % 2 ? packable(key, 16) : noise(key, 16)));
+    }
+    // evicted, replaced and removed values reach the listener decoded
+    for(int key = n; key < n + 10; key++) cache.save(value_type(Integer(key), packable(key, 16)));
+    cache.save(value_type(Integer(11), packable(0, 3)));
+    check(cache.remove(Integer(13)));
+    check(listener.seen.size() == 12);
+    for(int i = 0; i < 10; i++){
+        const sjtu::eviction &e = listener.seen[i];
+        check(e.key == i && e.value == (i % 2 ? packable(i, 16) : noise(i, 16)));
+    }
+    check(listener.seen[10].key == 11 && listener.seen[10].value == packable(11, 16));
+    check(listener.seen[11].key == 13 && listener.seen[11].value == packable(13, 16));
+
+    // hits decode, and turning it off decodes the rest in place
+    check(*cache.get(Integer(15)) == packable(15, 16) && *cache.get(Integer(14)) == noise(14, 16));
+    std::vector<Matrix<int> *> values;
+    for(int key = 16; key < n + 10; key++) values.push_back(cache.get(Integer(key)));
+    cache.compress_cold(false);
+    for(int key = 16; key < n + 10; key++){
+        const Matrix<int> expected = key >= n || key % 2 ? packable(key, 16) : noise(key, 16);
+        check(*values[key - 16] == expected && cache.lookup(Integer(key)) == expected);
+    }
+    cache.listen(nullptr);
+    std::cout<<"round trip"<<c[0]<<std::endl;
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("32.out","w",stdout);
+#endif
+    get_or_load_tester();
+    footprint_tester();
+    round_trip_tester();
+    std::cout << c[2] << std::endl;
+}
@@ -0,0 +1,158 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cstdio>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void check(bool ok){
+    if(!ok){
+        std::cout<<c[1]<<std::endl;
+        exit(0);
+    }
+}
+
+using value_type = sjtu::pair<Integer,Matrix<int> >;
+
+// whether p holds a 1x1 matrix of v
+bool holds(const Matrix<int> *p, int v){
+    return p != nullptr && *p == Matrix<int>(1, 1, v);
+}
+
+// every resident key is found, every other one is not
+void check_keys(sjtu::lru &cache, const std::vector<bool> &present){
+    Matrix<int> value;
+    for(size_t key = 0; key < present.size(); key++){
+        bool found = cache.try_lookup(int(key), value);
+        check(found == present[key]);
+        if(found) check(value[0][0] == int(key));
+    }
+}
+
+void filter_tester(){
+    const int capacity = 200, keys = 1000;
+    sjtu::lru cache(capacity);
+    cache.filter_misses(true);
+    std::vector<bool> present(keys, false);
+    check_keys(cache, present);
+    // save and remove at random, never more than capacity resident,
+    // long enough for the stale bits to force several rebuilds
+    unsigned seed = 12345;
+    int resident = 0;
+    for(int round = 0; round < 20000; round++){
+        seed = seed * 1103515245u + 12345u;
+        int key = (seed >> 8) % keys;
+        if(present[key]){
+            check(cache.remove(Integer(key)));
+            present[key] = false;
+            resident--;
+        }else if(resident < capacity){
+            cache.save(value_type(Integer(key), Matrix<int>(1, 1, key)));
+            present[key] = true;
+            resident++;
+        }
+        if(round % 1000 == 0) check_keys(cache, present);
+    }
+    check_keys(cache, present);
+
+    // evictions only: the newest capacity keys stay
+    cache.clear();
+    present.assign(keys, false);
+    check_keys(cache, present);
+    for(int key = 0; key < keys; key++){
+        cache.save(value_type(Integer(key), Matrix<int>(1, 1, key)));
+        present[key] = true;
+        if(key >= capacity) present[key - capacity] = false;
+    }
+    check_keys(cache, present);
+    check(holds(cache.get(keys - 1), keys - 1) && cache.lookup(Integer(keys - 2))[0][0] == keys - 2);
+
+    // off and on again is rebuilt from what is resident
+    cache.filter_misses(false);
+    check_keys(cache, present);
+    cache.filter_misses(true);
+    check_keys(cache, present);
+    std::cout<<"filter_misses"<<c[0]<<std::endl;
+}
+
+void negative_tester(){
+    sjtu::lru cache(100);
+    int loads = 0;
+    std::vector<bool> exists(50, false);
+    auto loader = [&](const Integer &key, Matrix<int> &value){
+        loads++;
+        if(!exists[key.val]) return false;
+        value = Matrix<int>(1, 1, key.val);
+        return true;
+    };
+    cache.cache_misses(0.1, std::chrono::hours(1));
+
+    // a remembered miss doesn't reach the loader
+    check(cache.get_or_load(Integer(7), loader) == nullptr && loads == 1);
+    check(cache.get_or_load(Integer(7), loader) == nullptr && loads == 1);
+    exists[7] = true;
+    check(cache.get_or_load(Integer(7), loader) == nullptr && loads == 1);
+
+    // save() and remove() forget it
+    check(cache.get_or_load(Integer(8), loader) == nullptr && loads == 2);
+    cache.save(value_type(Integer(8), Matrix<int>(1, 1, 80)));
+    check(holds(cache.get_or_load(Integer(8), loader), 80) && loads == 2);
+    check(!cache.remove(Integer(7)));
+    check(holds(cache.get_or_load(Integer(7), loader), 7) && loads == 3);
+    check(cache.remove(Integer(8)));
+    check(cache.get_or_load(Integer(8), loader) == nullptr && loads == 4);
+    check(cache.get_or_load(Integer(8), loader) == nullptr && loads == 4);
+
+    // only share * capacity of them, the oldest go first
+    for(int key = 20; key < 30; key++) check(cache.get_or_load(Integer(key), loader) == nullptr);
+    check(loads == 14);
+    check(cache.get_or_load(Integer(8), loader) == nullptr && loads == 15);
+    check(cache.get_or_load(Integer(29), loader) == nullptr && loads == 15);
+
+    // a miss expires after ttl
+    cache.cache_misses(1, std::chrono::milliseconds(30));
+    check(cache.get_or_load(Integer(30), loader) == nullptr && loads == 16);
+    check(cache.get_or_load(Integer(30), loader) == nullptr && loads == 16);
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    check(cache.get_or_load(Integer(30), loader) == nullptr && loads == 17);
+    check(cache.get_or_load(Integer(30), loader) == nullptr && loads == 17);
+
+    // share 0 stops
+    cache.cache_misses(0, std::chrono::hours(1));
+    check(cache.get_or_load(Integer(30), loader) == nullptr && loads == 18);
+    check(cache.get_or_load(Integer(30), loader) == nullptr && loads == 19);
+
+    // with the filter on as well, nothing resident is hidden
+    cache.filter_misses(true);
+    cache.cache_misses(1, std::chrono::hours(1));
+    for(int key = 0; key < 50; key++) exists[key] = key % 3 == 0;
+    int first = 0;
+    for(int round = 0; round < 2; round++){
+        for(int key = 0; key < 50; key++){
+            Matrix<int> *value = cache.get_or_load(Integer(key), loader);
+            check((value != nullptr) == (key % 3 == 0 || key == 7));
+        }
+        if(round == 0) first = loads;
+    }
+    check(loads == first);
+    std::cout<<"cache_misses"<<c[0]<<std::endl;
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("33.out","w",stdout);
+#endif
+    filter_tester();
+    negative_tester();
+    std::cout << c[2] << std::endl;
+}
@@ -0,0 +1,120 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+// the snapshot goes to the temporary directory, not the working one
+std::string temp_path(const char *name){
+    const char *dir = std::getenv("TMPDIR");
+    return std::string(dir && *dir ? dir : "/tmp") + "/" + name;
+}
+
+void snapshot_lru_tester(){
+    const std::string path = temp_path("sjtu-lru-9.snapshot");
+    using value_type = sjtu::pair<Integer,Matrix<int> >;
+    sjtu::lru tester(50);
+    const int n=1000;
+    for(int i=0;i<n;i++){
+        tester.save(value_type( Integer(i),Matrix<int>(i%3+1,2,i)));
+        tester.get(Integer(i-(i%7)));
+    }
+    tester.save_snapshot(path.c_str());
+
+    sjtu::lru restored(50);
+    restored.load_snapshot(path.c_str());
+    restored.print();
+    for(auto it = tester.map.begin(), jt = restored.map.begin(); it != tester.map.end(); ++it, ++jt){
+        if(jt == restored.map.end() || (*it).first.val != (*jt).first.val || !((*it).second == (*jt).second)){
+            std::cout<<c[1]<<std::endl;
+            std::remove(path.c_str());
+            exit(0);
+        }
+    }
+
+    // a smaller cache keeps only the newest entries
+    sjtu::lru small(10);
+    small.load_snapshot(path.c_str());
+    small.print();
+    std::remove(path.c_str());
+}
+
+// one hand-written entry: the header claims rows x cols, ints are what follows it
+struct raw_entry {
+    std::int32_t key;
+    std::uint64_t rows, cols;
+    std::vector<int> ints;
+};
+
+void write_snapshot(const std::string &path, std::uint64_t count, const std::vector<raw_entry> &entries){
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write("SJTULRU1", 8);
+    out.write(reinterpret_cast<const char *>(&count), sizeof(count));
+    for(const raw_entry &e : entries){
+        out.write(reinterpret_cast<const char *>(&e.key), sizeof(e.key));
+        out.write(reinterpret_cast<const char *>(&e.rows), sizeof(e.rows));
+        out.write(reinterpret_cast<const char *>(&e.cols), sizeof(e.cols));
+        out.write(reinterpret_cast<const char *>(e.ints.data()), e.ints.size() * sizeof(int));
+    }
+}
+
+// a broken snapshot throws runtime_error and leaves the cache as it was
+bool rejected(sjtu::lru &cache, const std::string &path, std::uint64_t count, const std::vector<raw_entry> &entries){
+    write_snapshot(path, count, entries);
+    bool thrown = false;
+    try{
+        cache.load_snapshot(path.c_str());
+    }catch(sjtu::runtime_error &){
+        thrown = true;
+    }catch(...){
+    }
+    return thrown && cache.map.size() == 1 && (*cache.get(Integer(7)))[0][0] == 7;
+}
+
+void corrupt_snapshot_tester(){
+    using value_type = sjtu::pair<Integer,Matrix<int> >;
+    const std::string path = temp_path("sjtu-lru-9.bad");
+    sjtu::lru cache(10);
+    cache.save(value_type(Integer(7),Matrix<int>(1,1,7)));
+    const std::uint64_t huge = std::uint64_t(1) << 62;
+    bool ok = rejected(cache, path, 2, {{1,1,1,{10}}, {1,1,1,{11}}})                // a repeated key
+           && rejected(cache, path, 1, {{1,huge,4,{1,2,3,4}}})                     // rows * cols * 4 wraps
+           && rejected(cache, path, 1, {{1,std::uint64_t(1) << 40,1,{1}}})         // more than the file holds
+           && rejected(cache, path, 1, {{1,4,huge,{1}}})
+           && rejected(cache, path, 1, {{1,2,2,{1,2,3}}})                          // a payload cut short
+           && rejected(cache, path, huge, {{1,1,1,{1}}})                           // a count past the end
+           && rejected(cache, path, 3, {{1,1,1,{1}}, {2,1,1,{2}}});
+    // the same checks hold for the entries skipped over capacity
+    sjtu::lru one(1);
+    one.save(value_type(Integer(7),Matrix<int>(1,1,7)));
+    ok = ok && rejected(one, path, 2, {{1,huge,4,{1}}, {2,1,1,{2}}});
+    // a well-formed one still loads, empty matrices included
+    write_snapshot(path, 3, {{1,0,5,{}}, {2,1,2,{20,21}}, {3,2,1,{30,31}}});
+    cache.load_snapshot(path.c_str());
+    ok = ok && cache.map.size() == 3 && cache.get(Integer(1))->ColSize() == 5 && (*cache.get(Integer(3)))[1][0] == 31;
+    cache.remove(Integer(2));
+    ok = ok && !cache.map.count(Integer(2)) && cache.map.size() == 2;
+    std::remove(path.c_str());
+    std::cout<<"corrupt snapshots "<<(ok ? c[0] : c[1])<<std::endl;
+}
+
+int main(){
+#ifdef _OUTPUT_
+    freopen("9.out","w",stdout);
+#endif
+    snapshot_lru_tester();
+    corrupt_snapshot_tester();
+    std::cout << c[2] << std::endl;
+}